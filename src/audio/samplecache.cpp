@@ -0,0 +1,358 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "samplecache.h"
+
+#include <QtCore/QMutexLocker>
+
+#include <vlc/vlc.h>
+
+#include "utils/debug.h"
+#include "media.h"
+
+// All clips are converted to this format on decoding, so voices can be mixed
+// without any conversion.
+#define SAMPLE_RATE 48000
+#define CHANNELS 2
+#define FRAME_BYTES (CHANNELS * int(sizeof(qint16)))
+
+// Clips longer than this are cut off, the cache is meant for short sounds.
+#define MAX_SAMPLE_SECONDS 10
+#define MAX_SAMPLE_BYTES (MAX_SAMPLE_SECONDS * SAMPLE_RATE * FRAME_BYTES)
+
+// Size of a mixed block. Each block is the granularity voices start at.
+#define BLOCK_MSECS 10
+#define BLOCK_FRAMES (SAMPLE_RATE * BLOCK_MSECS / 1000)
+#define BLOCK_SAMPLES (BLOCK_FRAMES * CHANNELS)
+
+// How far the mixer runs ahead of real time and how much the input buffers.
+// Together with the output device latency this is the trigger latency.
+#define OUTPUT_LEAD_MSECS 20
+#define OUTPUT_CACHING_MSECS 40
+
+namespace Phonon {
+namespace VLC {
+
+SampleCache::SampleCache(QObject *parent)
+    : QObject(parent)
+    , m_output(0)
+    , m_outputMedia(0)
+    , m_blocksMixed(0)
+    , m_outputQuit(false)
+    , m_nextVoiceId(1)
+{
+}
+
+SampleCache::~SampleCache()
+{
+    clear();
+}
+
+void SampleCache::preload(const QString &mrl)
+{
+    if (!m_output)
+        startOutput();
+
+    if (m_samples.contains(mrl)) {
+        emit preloaded(mrl, true);
+        return;
+    }
+    if (m_decoders.contains(mrl))
+        return;
+
+    debug() << "decoding" << mrl;
+    MediaPlayer *player = new MediaPlayer(this);
+    Decoder *decoder = new Decoder(player);
+    decoder->cache = this;
+    decoder->mrl = mrl;
+    decoder->player = player;
+    decoder->media = new Media(mrl.toUtf8(), this);
+    decoder->media->addOption(QLatin1String(":audio"));
+    decoder->truncated = false;
+
+    libvlc_audio_set_callbacks(*player, decodeCallback,
+                               nullptr, nullptr, nullptr, nullptr,
+                               decoder);
+    libvlc_audio_set_format(*player, "S16N", SAMPLE_RATE, CHANNELS);
+
+    connect(player, SIGNAL(stateChanged(MediaPlayer::State)),
+            this, SLOT(onDecoderStateChanged(MediaPlayer::State)));
+    m_decoders.insert(mrl, decoder);
+
+    player->setMedia(decoder->media);
+    if (!player->play())
+        finalizeDecoder(decoder, false);
+}
+
+bool SampleCache::isCached(const QString &mrl) const
+{
+    return m_samples.contains(mrl);
+}
+
+int SampleCache::play(const QString &mrl, qreal volume)
+{
+    const QByteArray pcm = m_samples.value(mrl);
+    if (pcm.isEmpty()) {
+        debug() << mrl << "is not cached";
+        preload(mrl);
+        return -1;
+    }
+    if (!m_output)
+        startOutput();
+
+    Voice voice;
+    voice.id = m_nextVoiceId++;
+    voice.pcm = pcm;
+    voice.position = 0;
+    voice.gain = qRound(qBound<qreal>(0.0, volume, 1.0) * 256);
+
+    QMutexLocker lock(&m_voiceMutex);
+    m_voices << voice;
+    return voice.id;
+}
+
+void SampleCache::stop(int voiceId)
+{
+    QMutexLocker lock(&m_voiceMutex);
+    QMutableListIterator<Voice> it(m_voices);
+    while (it.hasNext()) {
+        if (it.next().id == voiceId)
+            it.remove();
+    }
+}
+
+void SampleCache::remove(const QString &mrl)
+{
+    m_samples.remove(mrl);
+    if (Decoder *decoder = m_decoders.value(mrl))
+        finalizeDecoder(decoder, false);
+}
+
+void SampleCache::clear()
+{
+    DEBUG_BLOCK;
+    foreach (Decoder *decoder, m_decoders) {
+        finalizeDecoder(decoder, false);
+    }
+    m_samples.clear();
+    stopOutput();
+}
+
+void SampleCache::onDecoderStateChanged(MediaPlayer::State state)
+{
+    Decoder *decoder = nullptr;
+    foreach (Decoder *candidate, m_decoders) {
+        if (candidate->player == sender())
+            decoder = candidate;
+    }
+    if (!decoder)
+        return;
+
+    switch (state) {
+    case MediaPlayer::EndedState:
+        finalizeDecoder(decoder, true);
+        break;
+    case MediaPlayer::ErrorState:
+        finalizeDecoder(decoder, false);
+        break;
+    default:
+        break;
+    }
+}
+
+void SampleCache::finishDecoder(const QString &mrl)
+{
+    if (Decoder *decoder = m_decoders.value(mrl))
+        finalizeDecoder(decoder, true);
+}
+
+void SampleCache::finalizeDecoder(Decoder *decoder, bool success)
+{
+    m_decoders.remove(decoder->mrl);
+
+    MediaPlayer *player = decoder->player;
+    player->disconnect(this);
+    player->stop();
+
+    QByteArray pcm;
+    {
+        QMutexLocker lock(&decoder->mutex);
+        pcm = decoder->pcm;
+        if (decoder->truncated)
+            warning() << decoder->mrl << "is longer than" << MAX_SAMPLE_SECONDS << "seconds, truncated";
+    }
+    success = success && !pcm.isEmpty();
+    debug() << "decoded" << decoder->mrl << success << pcm.size() << "bytes";
+    if (success)
+        m_samples.insert(decoder->mrl, pcm);
+
+    // The decoder is a child of the player, it goes away once no callback
+    // can be running anymore.
+    const QString mrl = decoder->mrl;
+    decoder->media->deleteLater();
+    player->deleteLater();
+
+    emit preloaded(mrl, success);
+}
+
+void SampleCache::decodeCallback(void *data, const void *samples, unsigned count, int64_t pts)
+{
+    Q_UNUSED(pts);
+    Decoder *decoder = static_cast<Decoder *>(data);
+
+    QMutexLocker lock(&decoder->mutex);
+    if (decoder->truncated)
+        return;
+
+    const int bytes = count * FRAME_BYTES;
+    if (decoder->pcm.size() + bytes > MAX_SAMPLE_BYTES) {
+        decoder->truncated = true;
+        // No point in decoding the rest.
+        QMetaObject::invokeMethod(decoder->cache, "finishDecoder", Qt::QueuedConnection,
+                                  Q_ARG(QString, decoder->mrl));
+        return;
+    }
+    decoder->pcm.append(static_cast<const char *>(samples), bytes);
+}
+
+void SampleCache::startOutput()
+{
+    DEBUG_BLOCK;
+    {
+        QMutexLocker lock(&m_voiceMutex);
+        m_outputQuit = false;
+        m_blocksMixed = 0;
+        m_outputClock.invalidate();
+    }
+
+    m_output = new MediaPlayer(this);
+    libvlc_media_player_set_role(*m_output, libvlc_role_Notification);
+
+    // imem in ES mode: the get callback hands out raw PCM blocks with
+    // timestamps, no demuxer involved.
+    m_outputMedia = new Media(QByteArray("imem://"), this);
+    m_outputMedia->addOption(QLatin1String(":audio"));
+    m_outputMedia->addOption(QLatin1String(":imem-cat=1"));
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    m_outputMedia->addOption(QLatin1String(":imem-codec=s16b"));
+#else
+    m_outputMedia->addOption(QLatin1String(":imem-codec=s16l"));
+#endif
+    m_outputMedia->addOption(QLatin1String(":imem-channels="), QVariant(CHANNELS));
+    m_outputMedia->addOption(QLatin1String(":imem-samplerate="), QVariant(SAMPLE_RATE));
+    m_outputMedia->addOption(QLatin1String(":imem-caching="), QVariant(OUTPUT_CACHING_MSECS));
+    m_outputMedia->addOption(QLatin1String(":imem-data="), INTPTR_PTR(this));
+    m_outputMedia->addOption(QLatin1String(":imem-get="), INTPTR_FUNC(outputGetCallback));
+    m_outputMedia->addOption(QLatin1String(":imem-release="), INTPTR_FUNC(outputReleaseCallback));
+
+    m_output->setMedia(m_outputMedia);
+    if (!m_output->play())
+        error() << "failed to start the sample output";
+}
+
+void SampleCache::stopOutput()
+{
+    if (!m_output)
+        return;
+
+    DEBUG_BLOCK;
+    {
+        QMutexLocker lock(&m_voiceMutex);
+        m_outputQuit = true;
+        m_voices.clear();
+        m_outputWait.wakeAll();
+    }
+    m_output->stop();
+    // Deleted right away, releasing the player joins the input thread and
+    // with that the last call into outputGetCallback.
+    delete m_output;
+    m_output = 0;
+    delete m_outputMedia;
+    m_outputMedia = 0;
+}
+
+int SampleCache::outputGetCallback(void *data, const char *cookie,
+                                   int64_t *dts, int64_t *pts, unsigned *flags, // krazy:exclude=typedefs
+                                   size_t *bufferSize, void **buffer)
+{
+    Q_UNUSED(cookie);
+    Q_UNUSED(flags);
+
+    SampleCache *that = static_cast<SampleCache *>(data);
+    if (!that->mixBlock(pts, bufferSize, buffer))
+        return -1;
+    *dts = *pts;
+    return 0;
+}
+
+int SampleCache::outputReleaseCallback(void *data, const char *cookie,
+                                       size_t bufferSize, void *buffer)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(cookie);
+    Q_UNUSED(bufferSize);
+    delete[] static_cast<qint16 *>(buffer);
+    return 0;
+}
+
+bool SampleCache::mixBlock(int64_t *pts, size_t *bufferSize, void **buffer)
+{
+    QMutexLocker lock(&m_voiceMutex);
+
+    // Hand out blocks no earlier than OUTPUT_LEAD_MSECS before they are due,
+    // otherwise libvlc buffers ahead and new voices start late.
+    if (!m_outputClock.isValid())
+        m_outputClock.start();
+    forever {
+        if (m_outputQuit)
+            return false;
+        const qint64 due = m_blocksMixed * BLOCK_MSECS - OUTPUT_LEAD_MSECS;
+        const qint64 wait = due - m_outputClock.elapsed();
+        if (wait <= 0)
+            break;
+        m_outputWait.wait(&m_voiceMutex, wait);
+    }
+
+    int mix[BLOCK_SAMPLES] = {};
+    QMutableListIterator<Voice> it(m_voices);
+    while (it.hasNext()) {
+        Voice &voice = it.next();
+        const qint16 *samples = reinterpret_cast<const qint16 *>(voice.pcm.constData());
+        const int total = voice.pcm.size() / int(sizeof(qint16));
+        const int count = qMin(total - voice.position, BLOCK_SAMPLES);
+        for (int i = 0; i < count; ++i) {
+            mix[i] += (samples[voice.position + i] * voice.gain) >> 8;
+        }
+        voice.position += count;
+        if (voice.position >= total)
+            it.remove();
+    }
+
+    qint16 *block = new qint16[BLOCK_SAMPLES];
+    for (int i = 0; i < BLOCK_SAMPLES; ++i) {
+        block[i] = static_cast<qint16>(qBound(-32768, mix[i], 32767));
+    }
+
+    *pts = m_blocksMixed * BLOCK_MSECS * 1000;
+    *bufferSize = BLOCK_SAMPLES * sizeof(qint16);
+    *buffer = block;
+    ++m_blocksMixed;
+    return true;
+}
+
+} // namespace VLC
+} // namespace Phonon
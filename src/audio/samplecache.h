@@ -0,0 +1,151 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_VLC_SAMPLECACHE_H
+#define PHONON_VLC_SAMPLECACHE_H
+
+#include <stdint.h>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QWaitCondition>
+
+#include "mediaplayer.h"
+
+namespace Phonon {
+namespace VLC {
+
+class Media;
+
+/** \brief Low latency playback of short, in-memory sound clips
+ *
+ * Going through a MediaObject costs media creation, demuxing, decoding and
+ * starting an audio output every single time, which is far too slow for UI
+ * and game sounds. The SampleCache decodes clips to PCM once (through
+ * libvlc's audio callbacks) and keeps them in memory.
+ *
+ * Playback happens through a single persistent player fed with raw PCM by
+ * the imem module. Its input callback mixes all active voices block by block
+ * and is paced to stay only slightly ahead of real time, so a triggered clip
+ * is audible after little more than the output latency.
+ *
+ * The cache is owned by the Backend and can be obtained through
+ * Backend::sampleCache(), all public API is invokable through the meta object.
+ */
+class SampleCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SampleCache(QObject *parent = nullptr);
+    ~SampleCache();
+
+    /**
+     * Decodes \p mrl into the cache, unless it is cached already. Completion
+     * is reported through preloaded(). This also opens the output so the first
+     * play() does not have to wait for it.
+     */
+    Q_INVOKABLE void preload(const QString &mrl);
+
+    Q_INVOKABLE bool isCached(const QString &mrl) const;
+
+    /**
+     * Starts a new voice playing the cached clip \p mrl.
+     *
+     * \param volume linear gain between 0.0 and 1.0
+     * \returns an id for stop(), or -1 if the clip is not cached (it gets
+     *          preloaded then)
+     */
+    Q_INVOKABLE int play(const QString &mrl, qreal volume = 1.0);
+
+    /// Stops the voice \p voiceId if it is still playing.
+    Q_INVOKABLE void stop(int voiceId);
+
+    /// Drops \p mrl from the cache. Voices playing it are not interrupted.
+    Q_INVOKABLE void remove(const QString &mrl);
+
+    /// Drops all clips and closes the output.
+    Q_INVOKABLE void clear();
+
+Q_SIGNALS:
+    void preloaded(const QString &mrl, bool success);
+
+private Q_SLOTS:
+    void onDecoderStateChanged(MediaPlayer::State state);
+    void finishDecoder(const QString &mrl);
+
+private:
+    /// Child of its player, so it outlives all callbacks of it.
+    struct Decoder : public QObject
+    {
+        explicit Decoder(QObject *parent) : QObject(parent) {}
+        SampleCache *cache;
+        QString mrl;
+        Media *media;
+        MediaPlayer *player;
+        QMutex mutex;
+        QByteArray pcm;
+        bool truncated;
+    };
+
+    struct Voice
+    {
+        int id;
+        QByteArray pcm;
+        int position;
+        int gain;
+    };
+
+    static void decodeCallback(void *data, const void *samples, unsigned count, int64_t pts);
+
+    static int outputGetCallback(void *data, const char *cookie,
+                                 int64_t *dts, int64_t *pts, unsigned *flags, // krazy:exclude=typedefs
+                                 size_t *bufferSize, void **buffer);
+    static int outputReleaseCallback(void *data, const char *cookie,
+                                     size_t bufferSize, void *buffer);
+
+    /// Mixes the next block of all voices. Blocks to keep in pace with real time.
+    bool mixBlock(int64_t *pts, size_t *bufferSize, void **buffer);
+
+    void startOutput();
+    void stopOutput();
+    void finalizeDecoder(Decoder *decoder, bool success);
+
+    QHash<QString, QByteArray> m_samples;
+    QHash<QString, Decoder *> m_decoders;
+
+    MediaPlayer *m_output;
+    Media *m_outputMedia;
+
+    // Shared with the output thread.
+    QMutex m_voiceMutex;
+    QWaitCondition m_outputWait;
+    QList<Voice> m_voices;
+    QElapsedTimer m_outputClock;
+    qint64 m_blocksMixed;
+    bool m_outputQuit;
+
+    int m_nextVoiceId;
+};
+
+} // namespace VLC
+} // namespace Phonon
+
+#endif // PHONON_VLC_SAMPLECACHE_H
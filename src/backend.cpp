@@ -33,19 +33,31 @@
 #include <vlc/libvlc_version.h>
 
 #include "audio/audiooutput.h"
+#include "audio/samplecache.h"
 #include "audio/volumefadereffect.h"
 #include "config.h"
 #include "devicemanager.h"
 #include "effect.h"
 #include "effectmanager.h"
 #include "mediaobject.h"
+#include "mediaparser.h"
 #include "sinknode.h"
 #include "utils/debug.h"
 #include "utils/libvlc.h"
 #include "utils/mime.h"
+#include "utils/prefetcher.h"
 #ifdef PHONON_EXPERIMENTAL
 #include "video/videodataoutput.h"
 #endif
+#ifdef PHONON_VLC_QUICK
+#include "video/videoitem.h"
+#endif
+#ifdef PHONON_VLC_SHARED_MEMORY
+#include "video/sharedmemoryoutput.h"
+#endif
+#ifdef PHONON_VLC_VIDEOSINK
+#include "video/videosinkoutput.h"
+#endif
 #include "video/videowidget.h"
 
 namespace Phonon
@@ -59,6 +71,9 @@ Backend::Backend(QObject *parent, const QVariantList &)
     : QObject(parent)
     , m_deviceManager(0)
     , m_effectManager(0)
+    , m_mediaParser(0)
+    , m_prefetcher(0)
+    , m_sampleCache(0)
 {
     self = this;
 
@@ -142,6 +157,9 @@ Backend::Backend(QObject *parent, const QVariantList &)
 
     m_deviceManager = new DeviceManager(this);
     m_effectManager = new EffectManager(this);
+    m_mediaParser = new MediaParser(this);
+    m_prefetcher = new Prefetcher(this);
+    m_sampleCache = new SampleCache(this);
 }
 
 Backend::~Backend()
@@ -174,8 +192,19 @@ QObject *Backend::createObject(BackendInterface::Class c, QObject *parent, const
     case VideoDataOutputClass:
         return new VideoDataOutput(parent);
 #endif
-    case VideoGraphicsObjectClass:
-        return nullptr; // No longer supported
+    case VideoGraphicsObjectClass: {
+#ifdef PHONON_VLC_QUICK
+        // The parent owns the item whatever it is, only an item can also be
+        // its visual parent.
+        VideoItem *item = new VideoItem;
+        item->setParent(parent);
+        if (QQuickItem *parentItem = qobject_cast<QQuickItem *>(parent))
+            item->setParentItem(parentItem);
+        return item;
+#else
+        return nullptr; // Built without Qt Quick
+#endif
+    }
     case EffectClass:
         return effectManager()->createEffect(args[0].toInt(), parent);
     case VideoWidgetClass:
@@ -348,5 +377,40 @@ EffectManager *Backend::effectManager() const
     return m_effectManager;
 }
 
+QObject *Backend::mediaParser() const
+{
+    return m_mediaParser;
+}
+
+Prefetcher *Backend::prefetcher() const
+{
+    return m_prefetcher;
+}
+
+QObject *Backend::sampleCache() const
+{
+    return m_sampleCache;
+}
+
+QObject *Backend::createVideoSinkOutput(QObject *parent)
+{
+#ifdef PHONON_VLC_VIDEOSINK
+    return new VideoSinkOutput(parent);
+#else
+    Q_UNUSED(parent);
+    return nullptr;
+#endif
+}
+
+QObject *Backend::createSharedMemoryOutput(QObject *parent)
+{
+#ifdef PHONON_VLC_SHARED_MEMORY
+    return new SharedMemoryOutput(parent);
+#else
+    Q_UNUSED(parent);
+    return nullptr;
+#endif
+}
+
 } // namespace VLC
 } // namespace Phonon
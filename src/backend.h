@@ -35,6 +35,9 @@ namespace VLC
 {
 class DeviceManager;
 class EffectManager;
+class MediaParser;
+class Prefetcher;
+class SampleCache;
 
 /** \brief Backend class for Phonon-VLC.
  *
@@ -79,6 +82,45 @@ public:
     /// \return The effect manager that is associated with this backend object.
     EffectManager *effectManager() const;
 
+    /**
+     * Bulk pre-parse service, lets applications parse MRLs concurrently
+     * without having to make them current in a MediaObject.
+     *
+     * \return The MediaParser associated with this backend object.
+     * \see MediaParser
+     */
+    Q_INVOKABLE QObject *mediaParser() const;
+
+    /// \return The page cache prefetcher for upcoming local sources.
+    Prefetcher *prefetcher() const;
+
+    /**
+     * Low latency playback of short clips such as UI and game sounds,
+     * bypassing MediaObject entirely.
+     *
+     * \return The SampleCache associated with this backend object.
+     * \see SampleCache
+     */
+    Q_INVOKABLE QObject *sampleCache() const;
+
+    /**
+     * Creates a sink feeding the decoded frames of the MediaObject it gets
+     * connected to (through connectNodes()) into a Qt Multimedia QVideoSink,
+     * see VideoSinkOutput.
+     *
+     * \return The new sink, or nullptr if built without Qt 6 Multimedia.
+     */
+    Q_INVOKABLE QObject *createVideoSinkOutput(QObject *parent = nullptr);
+
+    /**
+     * Creates a sink exporting the decoded frames of the MediaObject it gets
+     * connected to (through connectNodes()) into shared memory for other
+     * processes to read, see SharedMemoryOutput.
+     *
+     * \return The new sink, or nullptr if built without memfd support.
+     */
+    Q_INVOKABLE QObject *createSharedMemoryOutput(QObject *parent = nullptr);
+
     /**
      * Creates a backend object of the desired class and with the desired parent. Extra arguments can be provided.
      *
@@ -150,6 +192,9 @@ private:
 
     DeviceManager *m_deviceManager;
     EffectManager *m_effectManager;
+    MediaParser *m_mediaParser;
+    Prefetcher *m_prefetcher;
+    SampleCache *m_sampleCache;
 };
 
 } // namespace VLC
@@ -0,0 +1,102 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QtCore/QByteArray>
+#include <QtTest/QTest>
+
+#include "video/rgbswap.h"
+
+using namespace Phonon::VLC;
+
+/** \brief swapRedBlue() against the plain loop it replaced
+ *
+ * VideoDataOutput swaps every RGB888 frame it cannot get as BGR from VLC,
+ * row by row. Also checks both give the same result.
+ */
+class RgbSwapBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void swap_data();
+    void swap();
+    void scalar_data();
+    void scalar();
+
+private:
+    static QByteArray frame(int width, int height);
+};
+
+QByteArray RgbSwapBenchmark::frame(int width, int height)
+{
+    QByteArray data(width * height * 3, Qt::Uninitialized);
+    for (int i = 0; i < data.size(); ++i)
+        data[i] = char(i);
+    return data;
+}
+
+void RgbSwapBenchmark::swap_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+
+    QTest::newRow("720p") << 1280 << 720;
+    QTest::newRow("1080p") << 1920 << 1080;
+    // Odd row length, most of it is the vector loop's tail.
+    QTest::newRow("narrow") << 7 << 100000;
+}
+
+void RgbSwapBenchmark::swap()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+
+    QByteArray data = frame(width, height);
+    QByteArray expected = data;
+    for (int row = 0; row < height; ++row)
+        swapRedBlueScalar(reinterpret_cast<uchar *>(expected.data()) + row * width * 3, width);
+    uchar *bits = reinterpret_cast<uchar *>(data.data());
+    for (int row = 0; row < height; ++row)
+        swapRedBlue(bits + row * width * 3, width);
+    QCOMPARE(data, expected);
+
+    QBENCHMARK {
+        for (int row = 0; row < height; ++row)
+            swapRedBlue(bits + row * width * 3, width);
+    }
+}
+
+void RgbSwapBenchmark::scalar_data()
+{
+    swap_data();
+}
+
+void RgbSwapBenchmark::scalar()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+
+    QByteArray data = frame(width, height);
+    uchar *bits = reinterpret_cast<uchar *>(data.data());
+    QBENCHMARK {
+        for (int row = 0; row < height; ++row)
+            swapRedBlueScalar(bits + row * width * 3, width);
+    }
+}
+
+QTEST_GUILESS_MAIN(RgbSwapBenchmark)
+
+#include "rgbswapbenchmark.moc"
@@ -0,0 +1,147 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QtCore/QByteArray>
+#include <QtGui/QImage>
+#include <QtGui/QPainter>
+#include <QtTest/QTest>
+
+#include "video/yuvconverter.h"
+
+using Phonon::VLC::YuvConverter;
+
+/** \brief Throughput of YuvConverter on HD sources
+ *
+ * Converts a 1080p and a 4K I420 and NV12 frame to common window sizes,
+ * the work the surface painter does for every painted frame.
+ *
+ * drawImage() is the baseline: the RV32 path the surface painter used
+ * before, which scales a full size RGB32 frame into the target with
+ * QPainter. It does not include the I420 to RV32 conversion VLC ran in
+ * front of it, so it understates what the old path cost.
+ */
+class YuvConverterBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void convert_data();
+    void convert();
+    void drawImage_data();
+    void drawImage();
+};
+
+void YuvConverterBenchmark::convert_data()
+{
+    QTest::addColumn<QSize>("source");
+    QTest::addColumn<QSize>("target");
+    QTest::addColumn<bool>("semiPlanar");
+
+    const QSize fullHd(1920, 1080);
+    const QSize ultraHd(3840, 2160);
+    QTest::newRow("1080p to 1080p") << fullHd << fullHd << false;
+    QTest::newRow("1080p to 720p") << fullHd << QSize(1280, 720) << false;
+    QTest::newRow("1080p to 1080p NV12") << fullHd << fullHd << true;
+    QTest::newRow("4K to 4K") << ultraHd << ultraHd << false;
+    QTest::newRow("4K to 1080p") << ultraHd << fullHd << false;
+    QTest::newRow("4K to 1080p NV12") << ultraHd << fullHd << true;
+}
+
+void YuvConverterBenchmark::drawImage_data()
+{
+    QTest::addColumn<QSize>("source");
+    QTest::addColumn<QSize>("target");
+    QTest::addColumn<bool>("smooth");
+
+    // The old path painted without smooth transformation, the bilinear
+    // YuvConverter compares to the smooth rows in quality.
+    const QSize fullHd(1920, 1080);
+    const QSize ultraHd(3840, 2160);
+    QTest::newRow("1080p to 1080p") << fullHd << fullHd << false;
+    QTest::newRow("1080p to 720p") << fullHd << QSize(1280, 720) << false;
+    QTest::newRow("1080p to 720p smooth") << fullHd << QSize(1280, 720) << true;
+    QTest::newRow("4K to 4K") << ultraHd << ultraHd << false;
+    QTest::newRow("4K to 1080p") << ultraHd << fullHd << false;
+    QTest::newRow("4K to 1080p smooth") << ultraHd << fullHd << true;
+}
+
+void YuvConverterBenchmark::drawImage()
+{
+    QFETCH(QSize, source);
+    QFETCH(QSize, target);
+    QFETCH(bool, smooth);
+
+    QImage frame(source, QImage::Format_RGB32);
+    uchar *bits = frame.bits();
+    for (qsizetype i = 0; i < frame.sizeInBytes(); ++i)
+        bits[i] = uchar(i * 7 + i / source.width());
+
+    QImage image(target, QImage::Format_RGB32);
+    const QRect rect(QPoint(0, 0), target);
+
+    QBENCHMARK {
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, smooth);
+        painter.drawImage(rect, frame);
+    }
+}
+
+void YuvConverterBenchmark::convert()
+{
+    QFETCH(QSize, source);
+    QFETCH(QSize, target);
+    QFETCH(bool, semiPlanar);
+
+    const int lumaSize = source.width() * source.height();
+    const int chromaWidth = (source.width() + 1) / 2;
+    const int chromaSize = chromaWidth * ((source.height() + 1) / 2);
+    QByteArray buffer(lumaSize + 2 * chromaSize, Qt::Uninitialized);
+    // Some gradient rather than a flat colour, clamping is not free.
+    for (int i = 0; i < buffer.size(); ++i)
+        buffer[i] = char(i * 7 + i / source.width());
+    const uchar *bits = reinterpret_cast<const uchar *>(buffer.constData());
+
+    YuvConverter::Frame frame;
+    frame.size = source;
+    frame.planes[0] = bits;
+    frame.pitches[0] = source.width();
+    if (semiPlanar) {
+        frame.layout = YuvConverter::SemiPlanar;
+        frame.planes[1] = bits + lumaSize;
+        frame.pitches[1] = 2 * chromaWidth;
+        frame.planes[2] = 0;
+        frame.pitches[2] = 0;
+    } else {
+        frame.layout = YuvConverter::Planar;
+        frame.planes[1] = bits + lumaSize;
+        frame.pitches[1] = chromaWidth;
+        frame.planes[2] = bits + lumaSize + chromaSize;
+        frame.pitches[2] = chromaWidth;
+    }
+
+    YuvConverter converter;
+    QImage image(target, QImage::Format_RGB32);
+    // Taps are built on first use, keep that out of the measurement.
+    converter.convert(frame, &image);
+
+    QBENCHMARK {
+        converter.convert(frame, &image);
+    }
+}
+
+QTEST_GUILESS_MAIN(YuvConverterBenchmark)
+
+#include "yuvconverterbenchmark.moc"
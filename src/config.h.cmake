@@ -23,5 +23,8 @@
 
 #cmakedefine PHONON_VLC_VERSION "@PHONON_VLC_VERSION@"
 #cmakedefine PHONON_EXPERIMENTAL
+#cmakedefine PHONON_VLC_QUICK
+#cmakedefine PHONON_VLC_VIDEOSINK
+#cmakedefine PHONON_VLC_SHARED_MEMORY
 
 #endif // PHONON_VLC_CONFIG_H
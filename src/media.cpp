@@ -31,6 +31,7 @@ namespace VLC {
 Media::Media(const QByteArray &mrl, QObject *parent) :
     QObject(parent),
     m_media(libvlc_media_new_location(pvlc_libvlc, mrl.constData())),
+    m_changedMetas(0),
     m_mrl(mrl)
 {
     Q_ASSERT(m_media);
@@ -70,6 +71,133 @@ QString Media::meta(libvlc_meta_t meta)
     return VString(libvlc_media_get_meta(m_media, meta)).toQString();
 }
 
+qint64 Media::duration() const
+{
+    return libvlc_media_get_duration(m_media);
+}
+
+bool Media::parse(int flags, int timeout)
+{
+#if (LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0))
+    return libvlc_media_parse_request(pvlc_libvlc, m_media,
+                                      static_cast<libvlc_media_parse_flag_t>(flags),
+                                      timeout) == 0;
+#else
+    return libvlc_media_parse_with_options(m_media,
+                                           static_cast<libvlc_media_parse_flag_t>(flags),
+                                           timeout) == 0;
+#endif
+}
+
+void Media::stopParse()
+{
+#if (LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0))
+    libvlc_media_parse_stop(pvlc_libvlc, m_media);
+#else
+    libvlc_media_parse_stop(m_media);
+#endif
+}
+
+static inline quint32 fourcc(char a, char b, char c, char d)
+{
+    return quint32(uchar(a)) | quint32(uchar(b)) << 8
+            | quint32(uchar(c)) << 16 | quint32(uchar(d)) << 24;
+}
+
+bool MediaTrack::isStillImage() const
+{
+    if (type != libvlc_track_video)
+        return false;
+    // Pictures come without a frame rate, motion JPEG et al. have one.
+    if (frameRateNum != 0 && frameRateDen != 0)
+        return false;
+    return codec == fourcc('p', 'n', 'g', ' ')
+            || codec == fourcc('j', 'p', 'e', 'g')
+            || codec == fourcc('b', 'm', 'p', ' ')
+            || codec == fourcc('g', 'i', 'f', ' ');
+}
+
+static MediaTrack toMediaTrack(const libvlc_media_track_t *track)
+{
+    MediaTrack ret;
+    ret.type = track->i_type;
+    ret.codec = track->i_codec;
+    ret.language = QString::fromUtf8(track->psz_language);
+    ret.description = QString::fromUtf8(track->psz_description);
+    ret.bitrate = track->i_bitrate;
+    ret.width = 0;
+    ret.height = 0;
+    ret.frameRateNum = 0;
+    ret.frameRateDen = 0;
+    ret.channels = 0;
+    ret.rate = 0;
+
+    switch (track->i_type) {
+    case libvlc_track_video:
+        ret.width = track->video->i_width;
+        ret.height = track->video->i_height;
+        ret.frameRateNum = track->video->i_frame_rate_num;
+        ret.frameRateDen = track->video->i_frame_rate_den;
+        break;
+    case libvlc_track_audio:
+        ret.channels = track->audio->i_channels;
+        ret.rate = track->audio->i_rate;
+        break;
+    case libvlc_track_text:
+    case libvlc_track_unknown:
+        break;
+    }
+    return ret;
+}
+
+QList<MediaTrack> Media::tracks() const
+{
+    QList<MediaTrack> ret;
+#if (LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0))
+    const libvlc_track_type_t types[] = {
+        libvlc_track_audio,
+        libvlc_track_video,
+        libvlc_track_text
+    };
+    for (const libvlc_track_type_t type : types) {
+        libvlc_media_tracklist_t *list = libvlc_media_get_tracklist(m_media, type);
+        if (!list)
+            continue;
+        for (size_t i = 0; i < libvlc_media_tracklist_count(list); ++i) {
+            ret << toMediaTrack(libvlc_media_tracklist_at(list, i));
+        }
+        libvlc_media_tracklist_delete(list);
+    }
+#else
+    libvlc_media_track_t **tracks = nullptr;
+    const unsigned int count = libvlc_media_tracks_get(m_media, &tracks);
+    for (unsigned int i = 0; i < count; ++i) {
+        ret << toMediaTrack(tracks[i]);
+    }
+    if (tracks)
+        libvlc_media_tracks_release(tracks, count);
+#endif
+    return ret;
+}
+
+QList<qint64> Media::subitemDurations() const
+{
+    QList<qint64> ret;
+    libvlc_media_list_t *list = libvlc_media_subitems(m_media);
+    if (!list)
+        return ret;
+    libvlc_media_list_lock(list);
+    const int count = libvlc_media_list_count(list);
+    for (int i = 0; i < count; ++i) {
+        libvlc_media_t *item = libvlc_media_list_item_at_index(list, i);
+        ret << libvlc_media_get_duration(item);
+        libvlc_media_release(item);
+    }
+    libvlc_media_list_unlock(list);
+    libvlc_media_list_release(list);
+    return ret;
+}
+
 void Media::event_cb(const libvlc_event_t *event, void *opaque)
 {
     Media *that = reinterpret_cast<Media *>(opaque);
@@ -83,23 +211,52 @@ void Media::event_cb(const libvlc_event_t *event, void *opaque)
                     Q_ARG(qint64, event->u.media_duration_changed.new_duration));
         break;
     case libvlc_MediaMetaChanged:
+        that->queueMetaChange(metaBit(event->u.media_meta_changed.meta_type));
+        break;
+    case libvlc_MediaParsedChanged:
+        // Parsing may have merged meta data without announcing every key.
+        if (event->u.media_parsed_changed.new_status == libvlc_media_parsed_status_done)
+            that->queueMetaChange(~0u);
         QMetaObject::invokeMethod(
-                    that, "metaDataChanged",
-                    Qt::QueuedConnection);
+                    that, "parsedChanged",
+                    Qt::QueuedConnection,
+                    Q_ARG(int, event->u.media_parsed_changed.new_status));
         break;
     case libvlc_MediaSubItemAdded:
-    case libvlc_MediaParsedChanged:
     case libvlc_MediaFreed:
     case libvlc_MediaStateChanged:
         break;
     }
 }
 
+void Media::queueMetaChange(uint changedMetas)
+{
+    // Opening a file or a radio station updating its NowPlaying fire a burst
+    // of events, one per key. Only the first change of a burst schedules a
+    // flush, the others merely add their bit to the pending mask.
+    const uint previous = static_cast<uint>(m_changedMetas.fetchAndOrOrdered(static_cast<int>(changedMetas)));
+    if (previous == 0) {
+        QMetaObject::invokeMethod(this, "flushMetaChanges", Qt::QueuedConnection);
+    }
+}
+
+void Media::flushMetaChanges()
+{
+    const uint changedMetas = static_cast<uint>(m_changedMetas.fetchAndStoreOrdered(0));
+    if (changedMetas != 0)
+        emit metaDataChanged(changedMetas);
+}
+
 void Media::setCdTrack(int track)
 {
     debug() << "setting CDDA track" << track;
     addOption(QLatin1String(":cdda-track="), QVariant(track));
 }
 
+bool Media::stats(libvlc_media_stats_t *stats) const
+{
+    return libvlc_media_get_stats(m_media, stats);
+}
+
 } // namespace VLC
 } // namespace Phonon
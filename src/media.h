@@ -18,6 +18,7 @@
 #ifndef PHONON_VLC_MEDIA_H
 #define PHONON_VLC_MEDIA_H
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QObject>
 #include <QtCore/QStringBuilder>
 #include <QtCore/QVariant>
@@ -36,6 +37,35 @@
 namespace Phonon {
 namespace VLC {
 
+/**
+ * Plain copy of the elementary stream information libVLC produces while
+ * parsing a media. Unlike libvlc_media_track_t this outlives the track list.
+ */
+struct MediaTrack
+{
+    libvlc_track_type_t type;
+    quint32 codec;
+    QString language;
+    QString description;
+    unsigned int bitrate;
+
+    // Video
+    unsigned int width;
+    unsigned int height;
+    unsigned int frameRateNum;
+    unsigned int frameRateDen;
+
+    // Audio
+    unsigned int channels;
+    unsigned int rate;
+
+    /**
+     * \returns whether this is a video track carrying a single picture, like
+     * the cover art of an audio file, rather than actual video
+     */
+    bool isStillImage() const;
+};
+
 class Media : public QObject
 {
     Q_OBJECT
@@ -62,16 +92,63 @@ public:
 
     QString meta(libvlc_meta_t meta);
 
+    /// \returns the duration as known to libvlc, -1 when not known yet
+    qint64 duration() const;
+
+    /**
+     * Starts asynchronous parsing of the media. Completion is signaled through
+     * parsedChanged().
+     *
+     * \param flags libvlc_media_parse_flag_t, local or network parsing
+     * \param timeout in milliseconds, -1 for the libvlc default, 0 for infinite
+     * \returns \c true when the request was queued
+     */
+    bool parse(int flags, int timeout);
+
+    /// Aborts a running parse request, parsedChanged() is still emitted.
+    void stopParse();
+
+    /// \returns all elementary streams found while parsing or playing
+    QList<MediaTrack> tracks() const;
+
+    /**
+     * \returns durations in milliseconds of all subitems found while parsing,
+     * e.g. the tracks of an audio CD
+     */
+    QList<qint64> subitemDurations() const;
+
     void setCdTrack(int track);
 
+    /// Fills \p stats with the input and decoder counters of the playing media.
+    bool stats(libvlc_media_stats_t *stats) const;
+
+    /// \returns bit for \p meta as used by metaDataChanged()
+    static inline uint metaBit(libvlc_meta_t meta) { return 1u << static_cast<uint>(meta); }
+
 Q_SIGNALS:
     void durationChanged(qint64 duration);
-    void metaDataChanged();
+
+    /**
+     * Emitted once per burst of libVLC meta changes.
+     * \param changedMetas bitmask of changed libvlc_meta_t, see metaBit()
+     */
+    void metaDataChanged(uint changedMetas);
+
+    /// \param status libvlc_media_parsed_status_t
+    void parsedChanged(int status);
+
+private Q_SLOTS:
+    /// Emits all meta changes collected since the last emission.
+    void flushMetaChanges();
 
 private:
     static void event_cb(const libvlc_event_t *event, void *opaque);
 
+    /// Marks metas as changed and schedules a flush if none is pending.
+    void queueMetaChange(uint changedMetas);
+
     libvlc_media_t *m_media;
+    QAtomicInt m_changedMetas;
     libvlc_state_t m_state;
     QByteArray m_mrl;
 };
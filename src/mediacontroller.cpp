@@ -394,7 +394,7 @@ void MediaController::setCurrentTitle(int title)
 
     switch (source().discType()) {
     case Cd:
-        m_player->setCdTrack(title);
+        changeCdTrack(title);
         return;
     case Dvd:
     case Vcd:
@@ -78,6 +78,12 @@ public:
     void chapterAdded(int titleId, const QString &name);
 
 protected:
+    /**
+     * Implemented by MediaObject, which knows whether the CD is played as a
+     * whole, in which case changing the track is merely a seek.
+     */
+    virtual void changeCdTrack(int track) = 0;
+
     // AudioChannel
     void setCurrentAudioChannel(const Phonon::AudioChannelDescription &audioChannel);
     QList<Phonon::AudioChannelDescription> availableAudioChannels() const;
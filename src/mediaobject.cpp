@@ -33,14 +33,40 @@
 
 #include "utils/debug.h"
 #include "utils/libvlc.h"
+#include "utils/prefetcher.h"
+#include "backend.h"
 #include "media.h"
 #include "sinknode.h"
+#include "standbypool.h"
 #include "streamreader.h"
 
 //Time in milliseconds before sending aboutToFinish() signal
 //2 seconds
 static const int ABOUT_TO_FINISH_TIME = 2000;
 
+// Time in milliseconds before the end of a CD track at which the precise
+// end timer gets armed. Must exceed the interval of libvlc time updates.
+static const int END_SCHEDULE_TIME = 1000;
+
+// libvlc's input-repeat is bounded, this keeps looping for a good while.
+static const int INPUT_REPEAT_COUNT = 65535;
+
+// CD audio is addressed in sectors of 1/75 second.
+static const int CDDA_SECTORS_PER_SECOND = 75;
+
+// Timeout in milliseconds for reading the track layout of a CD.
+static const int CD_LAYOUT_TIMEOUT = 5000;
+
+// Timeout in milliseconds for probing the tracks of a local file. Play gets
+// deferred meanwhile, a local parse normally completes in a few milliseconds.
+// The timeout also covers the time the probe waits for a preparser thread.
+static const int TRACK_PROBE_TIMEOUT = 500;
+
+// Time in milliseconds all video sinks need to be invisible before video
+// decoding gets suspended. Bridges brief hides like reparenting or switching
+// virtual desktops.
+static const int VIDEO_SUSPEND_DELAY = 2000;
+
 namespace Phonon {
 namespace VLC {
 
@@ -52,6 +78,22 @@ MediaObject::MediaObject(QObject *parent)
     , m_tickInterval(0)
     , m_transitionTime(0)
     , m_media(0)
+    , m_standbyPool(0)
+    , m_looping(false)
+    , m_mediaRepeats(false)
+    , m_loopStart(-1)
+    , m_loopEnd(-1)
+    , m_cdLayoutMedia(0)
+    , m_cdSpanning(false)
+    , m_cdSeekPending(false)
+    , m_cdTrackEndTimer(new QTimer(this))
+    , m_trackProbeMedia(0)
+    , m_trackProbeTimer(new QTimer(this))
+    , m_tracksProbed(false)
+    , m_audioOnly(false)
+    , m_playPending(false)
+    , m_videoSuspendTimer(new QTimer(this))
+    , m_videoSuspended(false)
 {
     qRegisterMetaType<QMultiMap<QString, QString> >("QMultiMap<QString, QString>");
 
@@ -60,18 +102,24 @@ MediaObject::MediaObject(QObject *parent)
     if (!m_player->libvlc_media_player())
         error() << "libVLC:" << LibVLC::errorMessage();
 
-    // Player signals.
-    connect(m_player, SIGNAL(seekableChanged(bool)), this, SIGNAL(seekableChanged(bool)));
-    connect(m_player, SIGNAL(timeChanged(qint64)), this, SLOT(timeChanged(qint64)));
-    connect(m_player, SIGNAL(stateChanged(MediaPlayer::State)), this, SLOT(updateState(MediaPlayer::State)));
-    connect(m_player, SIGNAL(hasVideoChanged(bool)), this, SLOT(onHasVideoChanged(bool)));
-    connect(m_player, SIGNAL(bufferChanged(int)), this, SLOT(setBufferStatus(int)));
-    connect(m_player, SIGNAL(timeChanged(qint64)), this, SLOT(timeChanged(qint64)));
+    connectPlayer();
 
     // Internal Signals.
     connect(this, SIGNAL(moveToNext()), SLOT(moveToNextSource()));
     connect(m_refreshTimer, SIGNAL(timeout()), this, SLOT(refreshDescriptors()));
 
+    connect(m_cdTrackEndTimer, SIGNAL(timeout()), this, SLOT(cdTrackEnded()));
+    m_cdTrackEndTimer->setSingleShot(true);
+    m_cdTrackEndTimer->setTimerType(Qt::PreciseTimer);
+
+    connect(m_trackProbeTimer, SIGNAL(timeout()), this, SLOT(onTrackProbeTimeout()));
+    m_trackProbeTimer->setSingleShot(true);
+    m_trackProbeTimer->setInterval(TRACK_PROBE_TIMEOUT);
+
+    connect(m_videoSuspendTimer, SIGNAL(timeout()), this, SLOT(suspendVideo()));
+    m_videoSuspendTimer->setSingleShot(true);
+    m_videoSuspendTimer->setInterval(VIDEO_SUSPEND_DELAY);
+
     resetMembers();
 }
 
@@ -91,6 +139,16 @@ MediaObject::~MediaObject()
     PulseSupport::shutdown();
 }
 
+void MediaObject::connectPlayer()
+{
+    // Player signals.
+    connect(m_player, SIGNAL(seekableChanged(bool)), this, SIGNAL(seekableChanged(bool)));
+    connect(m_player, SIGNAL(timeChanged(qint64)), this, SLOT(timeChanged(qint64)));
+    connect(m_player, SIGNAL(stateChanged(MediaPlayer::State)), this, SLOT(updateState(MediaPlayer::State)));
+    connect(m_player, SIGNAL(hasVideoChanged(bool)), this, SLOT(onHasVideoChanged(bool)));
+    connect(m_player, SIGNAL(bufferChanged(int)), this, SLOT(setBufferStatus(int)));
+}
+
 void MediaObject::resetMembers()
 {
     // default to -1, so that streams won't break and to comply with the docs (-1 if unknown)
@@ -102,6 +160,13 @@ void MediaObject::resetMembers()
     m_aboutToFinishEmitted = false;
 
     m_lastTick = 0;
+    m_lastTime = -1;
+
+    m_cdSpanning = false;
+    m_cdSeekPending = false;
+    m_cdTrackEndTimer->stop();
+
+    m_metaCache.clear();
 
     m_timesVideoChecked = 0;
 
@@ -127,6 +192,17 @@ void MediaObject::play()
         m_player->resume();
         break;
     default:
+        // Video sinks may have been connected after the source was set.
+        if (needsTrackProbe())
+            requestTrackProbe();
+        if (m_cdLayoutMedia || m_trackProbeMedia) {
+            // Wait for the CD layout so the disc can be opened as a whole,
+            // and for the track probe so audio only sources never get a
+            // video output. Both are bounded by their timeouts.
+            debug() << "deferring play until the source is probed";
+            m_playPending = true;
+            return;
+        }
         setupMedia();
         if (m_player->play())
             error() << "libVLC:" << LibVLC::errorMessage();
@@ -158,6 +234,7 @@ void MediaObject::stop()
     if (m_streamReader)
         m_streamReader->unlock();
     m_nextSource = MediaSource(QUrl());
+    m_playPending = false;
     m_player->stop();
 }
 
@@ -178,7 +255,14 @@ void MediaObject::seek(qint64 milliseconds)
 
     debug() << "seeking" << milliseconds << "msec";
 
-    m_player->setTime(milliseconds);
+    if (m_cdSpanning) {
+        m_cdTrackEndTimer->stop();
+        m_cdSeekPending = true;
+        m_player->setTime(cdTrackStart(m_currentTitle) + milliseconds);
+    } else {
+        m_player->setTime(milliseconds);
+    }
+    m_lastTime = -1;
 
     const qint64 time = currentTime();
     const qint64 total = totalTime();
@@ -194,8 +278,58 @@ void MediaObject::seek(qint64 milliseconds)
 
 void MediaObject::timeChanged(qint64 time)
 {
+    const qint64 lastTime = m_lastTime;
+    m_lastTime = time;
+
+    if (m_cdSpanning) {
+        if (m_cdSeekPending) {
+            // setTime() is asynchronous, until the input got there updates
+            // may still be inside the previous track.
+            if (time < cdTrackStart(m_currentTitle) || time >= cdTrackEnd(m_currentTitle)) {
+                m_lastTime = lastTime;
+                return;
+            }
+            m_cdSeekPending = false;
+        }
+
+        // The disc is one input, translate to the time within the track.
+        if (m_state == PlayingState || m_state == BufferingState) {
+            if (time >= cdTrackEnd(m_currentTitle)) {
+                const int track = m_currentTitle;
+                cdTrackEnded();
+                if (!m_cdSpanning || m_currentTitle == track)
+                    return;
+            } else if (cdTrackEnd(m_currentTitle) - time <= END_SCHEDULE_TIME
+                       && !m_cdTrackEndTimer->isActive()) {
+                m_cdTrackEndTimer->start(cdTrackEnd(m_currentTitle) - time);
+            }
+        }
+        time = qMax<qint64>(0, time - cdTrackStart(m_currentTitle));
+    }
+
     const qint64 totalTime = m_totalTime;
 
+    if (m_mediaRepeats && !m_looping && m_loopEnd < 0 && lastTime >= 0 && time < lastTime
+            && totalTime > 0 && lastTime >= totalTime - END_SCHEDULE_TIME) {
+        // The input was opened repeating but looping got turned off since.
+        // input-repeat cannot be changed on a running input, so treat the
+        // wrap around as the end.
+        debug() << "input wrapped around after looping was disabled";
+        m_mediaRepeats = false;
+        if (hasNextTrack()) {
+            moveToNextSource();
+        } else {
+            m_player->stop();
+            emitAboutToFinish();
+            emit finished();
+        }
+        return;
+    }
+
+    // The demuxer went back to the start of the media or loop region.
+    if (m_mediaRepeats && lastTime >= 0 && time < lastTime)
+        m_lastTick = time;
+
     switch (m_state) {
     case PlayingState:
     case BufferingState:
@@ -205,6 +339,10 @@ void MediaObject::timeChanged(qint64 time)
         break;
     }
 
+    // Looping media never finish.
+    if (m_looping || m_loopEnd >= 0)
+        return;
+
     if (m_state == PlayingState || m_state == BufferingState) { // Buffering is concurrent
         if (time >= totalTime - m_prefinishMark) {
             if (!m_prefinishEmitted) {
@@ -277,6 +415,8 @@ qint64 MediaObject::currentTime() const
     case Phonon::BufferingState:
     case Phonon::PlayingState:
         time = m_player->time();
+        if (m_cdSpanning)
+            time = qMax<qint64>(0, time - cdTrackStart(m_currentTitle));
         break;
     case Phonon::StoppedState:
     case Phonon::LoadingState:
@@ -322,6 +462,14 @@ void MediaObject::setSource(const MediaSource &source)
 
     // Reset previous isScreen flag
     m_isScreen = false;
+    m_cdSpanning = false;
+    m_cdSeekPending = false;
+    m_loopStart = -1;
+    m_loopEnd = -1;
+    m_audioOnly = false;
+    m_tracksProbed = false;
+    m_playPending = false;
+    abortTrackProbe();
 
     m_mediaSource = source;
 
@@ -346,6 +494,9 @@ void MediaObject::setSource(const MediaSource &source)
         }
         url += source.url().toEncoded();
         loadMedia(url);
+        // Start right away, play() otherwise waits for it.
+        if (needsTrackProbe())
+            requestTrackProbe();
         break;
     case MediaSource::Disc:
         switch (source.discType()) {
@@ -354,6 +505,8 @@ void MediaObject::setSource(const MediaSource &source)
             return;
         case Phonon::Cd:
             loadMedia(QStringLiteral("cdda://") % m_mediaSource.deviceName());
+            m_currentTitle = 1;
+            requestCdLayout();
             break;
         case Phonon::Dvd:
             loadMedia(QStringLiteral("dvd://") % m_mediaSource.deviceName());
@@ -442,6 +595,21 @@ void MediaObject::setNextSource(const MediaSource &source)
     // this function is called when we are in stoppedstate.
     if (m_state == StoppedState)
         moveToNext();
+    else if (m_nextSource.type() == MediaSource::LocalFile && Backend::self)
+        Backend::self->prefetcher()->prefetchNext(m_nextSource.fileName());
+}
+
+void MediaObject::setUpcomingSources(const QList<QUrl> &urls)
+{
+    QStringList files;
+    foreach (const QUrl &url, urls) {
+        if (url.isLocalFile())
+            files << url.toLocalFile();
+        else if (url.scheme().isEmpty())
+            files << url.toString();
+    }
+    if (Backend::self && Backend::self->prefetcher())
+        Backend::self->prefetcher()->prefetch(files);
 }
 
 qint32 MediaObject::prefinishMark() const
@@ -503,6 +671,7 @@ void MediaObject::changeState(Phonon::State newState)
     // State changed
     Phonon::State previousState = m_state;
     m_state = newState;
+
     emit stateChanged(m_state, previousState);
 }
 
@@ -523,6 +692,411 @@ void MediaObject::moveToNextSource()
     m_nextSource = MediaSource(QUrl());
 }
 
+void MediaObject::setStandbySources(const QList<QUrl> &urls)
+{
+    DEBUG_BLOCK;
+    if (!m_standbyPool) {
+        if (urls.isEmpty())
+            return;
+        m_standbyPool = new StandbyPool(this);
+    }
+    m_standbyPool->setSources(urls);
+}
+
+bool MediaObject::switchToStandbySource(const QUrl &url)
+{
+    DEBUG_BLOCK;
+    if (!m_standbyPool || m_streamReader)
+        return false;
+
+    const StandbyPool::Entry entry = m_standbyPool->take(url);
+    if (!entry.player) {
+        debug() << url << "is not in standby";
+        return false;
+    }
+
+    MediaPlayer *const oldPlayer = m_player;
+    Media *const oldMedia = m_media;
+    const QUrl oldUrl = m_mediaSource.url();
+    const bool wantsVideo = m_hasVideo || oldPlayer->hasVideoOutput();
+    const bool muted = oldPlayer->mute();
+
+    // Sinks cache the player, so they need to go through a full reconnect.
+    const QList<SinkNode *> sinks = m_sinks;
+    foreach (SinkNode *sink, sinks) {
+        sink->disconnectFromMediaObject(this);
+    }
+    // Only our own connections, others (e.g. a VideoWidget waiting for a
+    // snapshot) are still interested in the old player.
+    disconnect(oldPlayer, 0, this, 0);
+    if (oldMedia)
+        oldMedia->disconnect(this);
+
+    m_player = entry.player;
+    m_player->setParent(this);
+    m_media = entry.media;
+    m_media->setParent(this);
+    connectPlayer();
+    connect(m_media, SIGNAL(durationChanged(qint64)),
+            this, SLOT(updateDuration(qint64)));
+    connect(m_media, SIGNAL(metaDataChanged(uint)),
+            this, SLOT(updateMetaData(uint)));
+
+    foreach (SinkNode *sink, sinks) {
+        sink->connectToMediaObject(this);
+        sink->addToMedia(m_media);
+    }
+    m_player->setMute(muted);
+    m_player->setVideoEnabled(wantsVideo && !m_videoSuspended);
+
+    if (oldMedia)
+        m_standbyPool->adopt(oldUrl, oldMedia, oldPlayer);
+    else
+        oldPlayer->deleteLater();
+
+    resetMembers();
+    // The standby player decided on video long ago, there is no probing.
+    abortTrackProbe();
+    m_audioOnly = false;
+    m_tracksProbed = true;
+    m_playPending = false;
+    m_loopStart = -1;
+    m_loopEnd = -1;
+    m_mediaSource = MediaSource(url);
+    m_mrl = url.toEncoded();
+    emit currentSourceChanged(m_mediaSource);
+
+    updateDuration(m_media->duration());
+    updateMetaData(~0u);
+    // The new player got where it is in standby, without us listening.
+    // Whatever it is up to, an input that stalled or ended is not playing.
+    emit seekableChanged(m_player->isSeekable());
+    if (m_player->hasVideoOutput())
+        onHasVideoChanged(true);
+    updateState(m_player->state());
+    return true;
+}
+
+bool MediaObject::isLooping() const
+{
+    return m_looping;
+}
+
+void MediaObject::setLooping(bool looping)
+{
+    DEBUG_BLOCK;
+    m_looping = looping;
+}
+
+void MediaObject::setLoopRegion(qint64 start, qint64 end)
+{
+    DEBUG_BLOCK;
+    if (start < 0 || end <= start) {
+        warning() << "invalid loop region" << start << end;
+        return;
+    }
+    if (m_streamReader) {
+        // The reader cannot be reopened, nor does it seek on its own.
+        warning() << "loop regions are not supported for streams";
+        return;
+    }
+
+    debug() << "looping from" << start << "to" << end;
+    m_loopStart = start;
+    m_loopEnd = end;
+    reloadLoopRegion();
+}
+
+void MediaObject::clearLoopRegion()
+{
+    DEBUG_BLOCK;
+    if (m_loopEnd < 0)
+        return;
+    m_loopStart = -1;
+    m_loopEnd = -1;
+    reloadLoopRegion();
+}
+
+void MediaObject::reloadLoopRegion()
+{
+    switch (m_state) {
+    case PlayingState:
+    case PausedState:
+    case BufferingState:
+        break;
+    default:
+        // Picked up by setupMedia().
+        return;
+    }
+
+    // The bounds are options of the input, which cannot be changed while it
+    // runs. Reopen it, staying where we are if that is within the region.
+    const qint64 time = currentTime();
+    const bool paused = m_state == PausedState;
+    setupMedia();
+    if (m_loopEnd < 0 || (time >= m_loopStart && time < m_loopEnd))
+        m_seekpoint = time;
+    if (paused)
+        m_player->pausedPlay();
+    else
+        m_player->play();
+}
+
+void MediaObject::requestCdLayout()
+{
+    DEBUG_BLOCK;
+    if (m_cdLayoutMedia) {
+        m_cdLayoutMedia->disconnect(this);
+        m_cdLayoutMedia->stopParse();
+        m_cdLayoutMedia->deleteLater();
+    }
+    m_cdTrackSectors.clear();
+
+    // Without a track the cdda module lists the tracks of the disc.
+    m_cdLayoutMedia = new Media(m_mrl, this);
+    connect(m_cdLayoutMedia, SIGNAL(parsedChanged(int)),
+            this, SLOT(onCdLayoutParsed(int)));
+    if (!m_cdLayoutMedia->parse(libvlc_media_parse_local, CD_LAYOUT_TIMEOUT)) {
+        warning() << "failed to read the CD layout, falling back to per track playback";
+        m_cdLayoutMedia->deleteLater();
+        m_cdLayoutMedia = 0;
+    }
+}
+
+void MediaObject::onCdLayoutParsed(int status)
+{
+    Media *media = qobject_cast<Media *>(sender());
+    if (!media || media != m_cdLayoutMedia || status == 0)
+        return;
+
+    // Audio tracks are contiguous, so the cumulated lengths give the start
+    // sector of every track. Durations are exact to the millisecond, which
+    // is well below the length of a sector.
+    m_cdTrackSectors.clear();
+    if (status == libvlc_media_parsed_status_done) {
+        int sector = 0;
+        m_cdTrackSectors << sector;
+        foreach (qint64 duration, media->subitemDurations()) {
+            if (duration <= 0) {
+                m_cdTrackSectors.clear();
+                break;
+            }
+            sector += qRound(duration * CDDA_SECTORS_PER_SECOND / 1000.0);
+            m_cdTrackSectors << sector;
+        }
+        if (m_cdTrackSectors.size() < 2)
+            m_cdTrackSectors.clear();
+    }
+    debug() << "CD layout" << status << m_cdTrackSectors;
+
+    m_cdLayoutMedia = 0;
+    media->disconnect(this);
+    media->deleteLater();
+
+    if (m_playPending && !m_trackProbeMedia) {
+        m_playPending = false;
+        play();
+    }
+}
+
+bool MediaObject::needsTrackProbe() const
+{
+    if (m_tracksProbed || m_trackProbeMedia || !m_mrl.startsWith("file://"))
+        return false;
+    // Only cheap for local files, and only worth it with video sinks around.
+    foreach (SinkNode *sink, m_sinks) {
+        if (sink->isVideoSink())
+            return true;
+    }
+    return false;
+}
+
+void MediaObject::requestTrackProbe()
+{
+    abortTrackProbe();
+
+    m_trackProbeMedia = new Media(m_mrl, this);
+    connect(m_trackProbeMedia, SIGNAL(parsedChanged(int)),
+            this, SLOT(onTrackProbeParsed(int)));
+    if (!m_trackProbeMedia->parse(libvlc_media_parse_local, TRACK_PROBE_TIMEOUT)) {
+        warning() << "failed to probe the tracks of" << m_mrl;
+        m_trackProbeMedia->deleteLater();
+        m_trackProbeMedia = 0;
+        m_tracksProbed = true;
+        return;
+    }
+    // libVLC's timeout only starts once a preparser thread picks the media
+    // up, which may take a while behind a MediaParser batch.
+    m_trackProbeTimer->start();
+}
+
+void MediaObject::abortTrackProbe()
+{
+    m_trackProbeTimer->stop();
+    if (!m_trackProbeMedia)
+        return;
+    m_trackProbeMedia->disconnect(this);
+    m_trackProbeMedia->stopParse();
+    m_trackProbeMedia->deleteLater();
+    m_trackProbeMedia = 0;
+}
+
+void MediaObject::onTrackProbeParsed(int status)
+{
+    Media *media = qobject_cast<Media *>(sender());
+    if (!media || media != m_trackProbeMedia || status == 0)
+        return;
+
+    // Anything short of a complete parse leaves video enabled, better an
+    // unneeded video output than missing video.
+    if (status == libvlc_media_parsed_status_done) {
+        bool hasAudio = false;
+        bool hasVideo = false;
+        foreach (const MediaTrack &track, media->tracks()) {
+            if (track.type == libvlc_track_audio)
+                hasAudio = true;
+            else if (track.type == libvlc_track_video && !track.isStillImage())
+                hasVideo = true;
+        }
+        m_audioOnly = hasAudio && !hasVideo;
+    }
+    debug() << "track probe" << status << "audio only:" << m_audioOnly;
+
+    m_trackProbeTimer->stop();
+    m_trackProbeMedia = 0;
+    m_tracksProbed = true;
+    media->disconnect(this);
+    media->deleteLater();
+
+    if (m_playPending && !m_cdLayoutMedia) {
+        m_playPending = false;
+        play();
+    }
+}
+
+void MediaObject::onTrackProbeTimeout()
+{
+    warning() << "probing the tracks of" << m_mrl << "timed out";
+    abortTrackProbe();
+    m_tracksProbed = true;
+
+    if (m_playPending && !m_cdLayoutMedia) {
+        m_playPending = false;
+        play();
+    }
+}
+
+bool MediaObject::isAudioOnly() const
+{
+    return m_audioOnly;
+}
+
+void MediaObject::setupCdMedia(int track)
+{
+    m_currentTitle = qMax(1, track);
+
+    const int trackCount = m_cdTrackSectors.size() - 1;
+    if (m_currentTitle > trackCount) {
+        // Layout unknown, play the single track.
+        m_media->setCdTrack(m_currentTitle);
+        return;
+    }
+
+    debug() << "playing the whole CD starting at track" << m_currentTitle;
+    m_cdSpanning = true;
+    // Giving the sector range makes the cdda module read straight across
+    // the track boundaries.
+    m_media->setCdTrack(1);
+    m_media->addOption(QLatin1String(":cdda-first-sector="), QVariant(m_cdTrackSectors.first()));
+    m_media->addOption(QLatin1String(":cdda-last-sector="), QVariant(m_cdTrackSectors.last()));
+    if (m_currentTitle > 1)
+        m_media->addOption(QLatin1String(":start-time="), QVariant(cdTrackStart(m_currentTitle) / 1000.0));
+
+    m_availableTitles = trackCount;
+    emit availableTitlesChanged(m_availableTitles);
+}
+
+qint64 MediaObject::cdTrackStart(int track) const
+{
+    return qint64(m_cdTrackSectors.value(track - 1)) * 1000 / CDDA_SECTORS_PER_SECOND;
+}
+
+qint64 MediaObject::cdTrackEnd(int track) const
+{
+    return qint64(m_cdTrackSectors.value(track, m_cdTrackSectors.last())) * 1000 / CDDA_SECTORS_PER_SECOND;
+}
+
+void MediaObject::changeCdTrack(int track)
+{
+    DEBUG_BLOCK;
+    switch (m_state) {
+    case PlayingState:
+    case PausedState:
+    case BufferingState:
+        break;
+    default:
+        // Picked up by setupMedia().
+        return;
+    }
+
+    if (!m_cdSpanning) {
+        if (!m_cdTrackSectors.isEmpty()) {
+            // The layout arrived after the disc was opened, reopen once as
+            // a whole; all further track changes are seeks.
+            setupMedia();
+            m_player->play();
+        } else {
+            m_player->setCdTrack(track);
+        }
+        return;
+    }
+
+    if (track < 1 || track >= m_cdTrackSectors.size()) {
+        warning() << "no such CD track" << track;
+        return;
+    }
+    m_cdTrackEndTimer->stop();
+    // Switch first, the pending seek is checked against the new track.
+    startCdTrack(track);
+    m_cdSeekPending = true;
+    m_player->setTime(cdTrackStart(track));
+}
+
+void MediaObject::startCdTrack(int track)
+{
+    m_currentTitle = track;
+    m_lastTick = 0;
+    m_lastTime = -1;
+    m_prefinishEmitted = false;
+    m_aboutToFinishEmitted = false;
+    updateDuration(cdTrackEnd(track) - cdTrackStart(track));
+    emit titleChanged(track);
+}
+
+void MediaObject::cdTrackEnded()
+{
+    m_cdTrackEndTimer->stop();
+    if (!m_cdSpanning || (m_state != PlayingState && m_state != BufferingState))
+        return;
+
+    const int trackCount = m_cdTrackSectors.size() - 1;
+    if (hasNextTrack()) {
+        moveToNextSource();
+    } else if (m_autoPlayTitles && m_currentTitle < trackCount) {
+        // Nothing to do for libvlc, the input simply continues.
+        debug() << "CD track" << m_currentTitle << "ended, continuing";
+        startCdTrack(m_currentTitle + 1);
+    } else if (m_currentTitle < trackCount) {
+        debug() << "CD track" << m_currentTitle << "ended";
+        m_player->stop();
+        emitAboutToFinish();
+        emit finished();
+        // Do not wait for libvlc, further time updates must not end it again.
+        changeState(StoppedState);
+    }
+    // The end of the last track is the end of the input.
+}
+
 inline bool MediaObject::hasNextTrack()
 {
     return m_nextSource.type() != MediaSource::Invalid && m_nextSource.type() != MediaSource::Empty;
@@ -541,6 +1115,10 @@ void MediaObject::setupMedia()
 {
     DEBUG_BLOCK;
 
+    // Reset along with the other members, but setCurrentTitle() may have
+    // picked the CD track to start with.
+    const int cdTrack = m_currentTitle;
+
     unloadMedia();
     resetMembers();
 
@@ -552,9 +1130,6 @@ void MediaObject::setupMedia()
         m_media->addOption(QLatin1String("screen-caching=300"));
     }
 
-    if (source().discType() == Cd && m_currentTitle > 0)
-        m_media->setCdTrack(m_currentTitle);
-
     if (m_streamReader)
         // StreamReader is no sink but a source, for this we have no concept right now
         // also we do not need one since the reader is the only source we have.
@@ -564,6 +1139,12 @@ void MediaObject::setupMedia()
     if (!m_subtitleAutodetect)
         m_media->addOption(QLatin1String(":no-sub-autodetect-file"));
 
+    // Repeating inside the input seeks back in the demuxer instead of
+    // closing and reopening everything at the end.
+    m_mediaRepeats = m_looping && !m_streamReader;
+    if (m_mediaRepeats)
+        m_media->addOption(QLatin1String(":input-repeat="), INPUT_REPEAT_COUNT);
+
     if (m_subtitleEncoding != QLatin1String("UTF-8")) // utf8 is phonon default, so let vlc handle it
         m_media->addOption(QLatin1String(":subsdec-encoding="), m_subtitleEncoding);
 
@@ -590,8 +1171,8 @@ void MediaObject::setupMedia()
     // Connect to Media signals. Disconnection is done at unloading.
     connect(m_media, SIGNAL(durationChanged(qint64)),
             this, SLOT(updateDuration(qint64)));
-    connect(m_media, SIGNAL(metaDataChanged()),
-            this, SLOT(updateMetaData()));
+    connect(m_media, SIGNAL(metaDataChanged(uint)),
+            this, SLOT(updateMetaData(uint)));
 
     // Update available audio channels/subtitles/angles/chapters/etc...
     // i.e everything from MediaController
@@ -600,6 +1181,22 @@ void MediaObject::setupMedia()
     // This will reset the GUI
     resetMediaController();
 
+    if (source().discType() == Cd)
+        setupCdMedia(cdTrack);
+
+    if (m_loopEnd >= 0 && !m_streamReader) {
+        // The demuxer stops at the end of the region and input-repeat seeks
+        // back to its start, both at the accuracy of the demuxer rather than
+        // of our time updates.
+        const qint64 offset = m_cdSpanning ? cdTrackStart(m_currentTitle) : 0;
+        m_media->addOption(QLatin1String(":start-time="), QVariant((offset + m_loopStart) / 1000.0));
+        m_media->addOption(QLatin1String(":stop-time="), QVariant((offset + m_loopEnd) / 1000.0));
+        if (!m_mediaRepeats) {
+            m_mediaRepeats = true;
+            m_media->addOption(QLatin1String(":input-repeat="), INPUT_REPEAT_COUNT);
+        }
+    }
+
     // Play
     m_player->setMedia(m_media);
 }
@@ -632,17 +1229,49 @@ void MediaObject::updateDuration(qint64 newDuration)
     // VLC reports -1 with no media but 0 if it does not know the duration, so
     // apps that assume 0 = unknown get screwed if they query too early.
     // http://bugs.tomahawk-player.org/browse/TWK-1029
+    if (m_cdSpanning) // The media spans the whole disc, report the track.
+        newDuration = cdTrackEnd(m_currentTitle) - cdTrackStart(m_currentTitle);
     m_totalTime = newDuration;
     emit totalTimeChanged(m_totalTime);
 }
 
-void MediaObject::updateMetaData()
+void MediaObject::updateMetaData(uint changedMetas)
 {
+    static const libvlc_meta_t metas[] = {
+        libvlc_meta_Artist,
+        libvlc_meta_Title,
+        libvlc_meta_NowPlaying,
+        libvlc_meta_Album,
+        libvlc_meta_Date,
+        libvlc_meta_Genre,
+        libvlc_meta_TrackNumber,
+        libvlc_meta_Description,
+        libvlc_meta_Copyright,
+        libvlc_meta_URL,
+        libvlc_meta_EncodedBy,
+        libvlc_meta_ArtworkURL
+    };
+
+    // Every libvlc_media_get_meta takes the item lock and allocates, so only
+    // go through libVLC for the keys that actually changed.
+    bool cacheChanged = false;
+    for (const libvlc_meta_t meta : metas) {
+        if (!(changedMetas & Media::metaBit(meta)))
+            continue;
+        const QString value = m_media->meta(meta);
+        if (!m_metaCache.contains(meta) || m_metaCache.value(meta) != value) {
+            m_metaCache.insert(meta, value);
+            cacheChanged = true;
+        }
+    }
+    if (!cacheChanged)
+        return;
+
     QMultiMap<QString, QString> metaDataMap;
 
-    const QString artist = m_media->meta(libvlc_meta_Artist);
-    const QString title = m_media->meta(libvlc_meta_Title);
-    const QString nowPlaying = m_media->meta(libvlc_meta_NowPlaying);
+    const QString artist = m_metaCache.value(libvlc_meta_Artist);
+    const QString title = m_metaCache.value(libvlc_meta_Title);
+    const QString nowPlaying = m_metaCache.value(libvlc_meta_NowPlaying);
 
     // Streams sometimes have the artist and title munged in nowplaying.
     // With ALBUM = Title and TITLE = NowPlaying it will still show up nicely in Amarok.
@@ -650,18 +1279,20 @@ void MediaObject::updateMetaData()
         metaDataMap.insert(QLatin1String("ALBUM"), title);
         metaDataMap.insert(QLatin1String("TITLE"), nowPlaying);
     } else {
-        metaDataMap.insert(QLatin1String("ALBUM"), m_media->meta(libvlc_meta_Album));
+        metaDataMap.insert(QLatin1String("ALBUM"), m_metaCache.value(libvlc_meta_Album));
         metaDataMap.insert(QLatin1String("TITLE"), title);
     }
 
     metaDataMap.insert(QLatin1String("ARTIST"), artist);
-    metaDataMap.insert(QLatin1String("DATE"), m_media->meta(libvlc_meta_Date));
-    metaDataMap.insert(QLatin1String("GENRE"), m_media->meta(libvlc_meta_Genre));
-    metaDataMap.insert(QLatin1String("TRACKNUMBER"), m_media->meta(libvlc_meta_TrackNumber));
-    metaDataMap.insert(QLatin1String("DESCRIPTION"), m_media->meta(libvlc_meta_Description));
-    metaDataMap.insert(QLatin1String("COPYRIGHT"), m_media->meta(libvlc_meta_Copyright));
-    metaDataMap.insert(QLatin1String("URL"), m_media->meta(libvlc_meta_URL));
-    metaDataMap.insert(QLatin1String("ENCODEDBY"), m_media->meta(libvlc_meta_EncodedBy));
+    metaDataMap.insert(QLatin1String("DATE"), m_metaCache.value(libvlc_meta_Date));
+    metaDataMap.insert(QLatin1String("GENRE"), m_metaCache.value(libvlc_meta_Genre));
+    metaDataMap.insert(QLatin1String("TRACKNUMBER"), m_metaCache.value(libvlc_meta_TrackNumber));
+    metaDataMap.insert(QLatin1String("DESCRIPTION"), m_metaCache.value(libvlc_meta_Description));
+    metaDataMap.insert(QLatin1String("COPYRIGHT"), m_metaCache.value(libvlc_meta_Copyright));
+    metaDataMap.insert(QLatin1String("URL"), m_metaCache.value(libvlc_meta_URL));
+    metaDataMap.insert(QLatin1String("ENCODEDBY"), m_metaCache.value(libvlc_meta_EncodedBy));
+    // Cover art, VLC extracts embedded pictures to attachment:// URLs.
+    metaDataMap.insert(QLatin1String("ARTWORK_URL"), m_metaCache.value(libvlc_meta_ArtworkURL));
 
     if (metaDataMap == m_vlcMetaData) {
         // No need to issue any change, the data is the same
@@ -718,9 +1349,16 @@ void MediaObject::updateState(MediaPlayer::State state)
         changeState(StoppedState);
         break;
     case MediaPlayer::EndedState:
-        if (hasNextTrack()) {
+        if ((m_looping || m_loopEnd >= 0) && !m_attemptingAutoplay) {
+            // Looping was enabled after the media was set up (or the repeat
+            // count ran out), restart it with the same Media. A loop region
+            // starts at its start again.
+            debug() << "restarting looping media";
+            m_player->play();
+        } else if (hasNextTrack()) {
             moveToNextSource();
-        } else if (source().discType() == Cd && m_autoPlayTitles && !m_attemptingAutoplay) {
+        } else if (source().discType() == Cd && m_autoPlayTitles && !m_attemptingAutoplay
+                   && !m_cdSpanning) {
             debug() << "trying to simulate autoplay";
             m_attemptingAutoplay = true;
             m_player->setCdTrack(++m_currentTitle);
@@ -766,6 +1404,14 @@ void MediaObject::updateState(MediaPlayer::State state)
 void MediaObject::onHasVideoChanged(bool hasVideo)
 {
     DEBUG_BLOCK;
+    if (m_videoSuspended) {
+        if (!hasVideo) {
+            // Our own doing, to the application the video is still there.
+            return;
+        }
+        // A new source brought up a vout, nobody would see it.
+        m_player->setVideoEnabled(false);
+    }
     if (m_hasVideo != hasVideo) {
         m_hasVideo = hasVideo;
         emit hasVideoChanged(m_hasVideo);
@@ -836,6 +1482,69 @@ void MediaObject::removeSink(SinkNode *node)
 {
     Q_ASSERT(node);
     m_sinks.removeAll(node);
+    m_videoSinks.remove(node);
+    m_visibleVideoSinks.remove(node);
+    updateVideoSuspension();
+}
+
+void MediaObject::setVideoSinkVisible(SinkNode *sink, bool visible)
+{
+    m_videoSinks.insert(sink);
+    if (visible)
+        m_visibleVideoSinks.insert(sink);
+    else
+        m_visibleVideoSinks.remove(sink);
+    updateVideoSuspension();
+}
+
+void MediaObject::updateVideoSuspension()
+{
+    if (!m_visibleVideoSinks.isEmpty()) {
+        m_videoSuspendTimer->stop();
+        if (m_videoSuspended)
+            resumeVideo();
+        return;
+    }
+    // Without any video sinks (e.g. while they get reconnected) there is
+    // nothing to decide, video stays however it is.
+    if (m_videoSinks.isEmpty()) {
+        m_videoSuspendTimer->stop();
+    } else if (!m_videoSuspended && !m_videoSuspendTimer->isActive()) {
+        m_videoSuspendTimer->start();
+    }
+}
+
+void MediaObject::suspendVideo()
+{
+    DEBUG_BLOCK;
+    m_videoSuspended = true;
+    m_player->setVideoEnabled(false);
+}
+
+void MediaObject::restartVideo()
+{
+    DEBUG_BLOCK;
+    // Without a vout the next one gets set up as wanted anyway.
+    if (m_videoSuspended || !m_player->hasVideoOutput())
+        return;
+    m_player->setVideoEnabled(false);
+    resumeVideo();
+}
+
+void MediaObject::resumeVideo()
+{
+    DEBUG_BLOCK;
+    m_videoSuspended = false;
+    // There is nothing to show for audio only sources.
+    if (m_audioOnly)
+        return;
+    m_player->setVideoEnabled(true);
+    // The decoder picks up at the next keyframe, which may be seconds away.
+    // Seeking to where we are gets a picture right away.
+    if (m_player->isSeekable()
+            && (m_state == Phonon::PlayingState || m_state == Phonon::PausedState)) {
+        m_player->setTime(m_player->time());
+    }
 }
 
 } // namespace VLC
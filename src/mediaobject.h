@@ -22,7 +22,9 @@
 #ifndef PHONON_VLC_MEDIAOBJECT_H
 #define PHONON_VLC_MEDIAOBJECT_H
 
+#include <QtCore/QHash>
 #include <QtCore/QObject>
+#include <QtCore/QSet>
 #include <QtCore/QTimer>
 
 #include <phonon/mediaobjectinterface.h>
@@ -38,6 +40,7 @@ namespace VLC
 
 class Media;
 class SinkNode;
+class StandbyPool;
 class StreamReader;
 
 /** \brief Implementation for the most important class in Phonon
@@ -123,6 +126,16 @@ public:
     /// Removes a sink from this media object.
     void removeSink(SinkNode *node);
 
+    /// \returns the sinks connected to this media object
+    QList<SinkNode *> sinks() const { return m_sinks; }
+
+    /**
+     * Recreates a running video output, for sinks that changed how the
+     * player outputs video (e.g. set new memory callbacks). libVLC only
+     * applies those to the next vout.
+     */
+    void restartVideo();
+
     /**
      * Pushes a seek command to the SeekStack for this media object. The SeekStack then
      * calls seekInternal() when it's popped.
@@ -179,6 +192,83 @@ public:
     /// Sets the media source that will replace the current one, after the playback for it finishes.
     void setNextSource(const MediaSource &source) override;
 
+    /**
+     * Backend extension: announces the sources expected to be played after
+     * the current one. libphonon only ever hands us one next source, this
+     * allows players to look further ahead. Local files among them get their
+     * header and index prefetched into the page cache.
+     *
+     * \param urls upcoming sources in playback order, replaces earlier calls
+     */
+    Q_INVOKABLE void setUpcomingSources(const QList<QUrl> &urls);
+
+    /**
+     * Backend extension: keeps a pre-buffered, muted, video-less player
+     * running for each of \p urls (at most StandbyPool::maximumSize).
+     * Meant for switching between a handful of live sources.
+     *
+     * \see switchToStandbySource()
+     */
+    Q_INVOKABLE void setStandbySources(const QList<QUrl> &urls);
+
+    /**
+     * Backend extension: promotes the standby player for \p url to be the
+     * current output. This skips open and buffering entirely; the previous
+     * source goes into standby if it is one of the standby sources. The state
+     * becomes that of the standby player, which need not be playing if its
+     * input stalled or ended meanwhile.
+     *
+     * To check by hand, stream two UDP sources, e.g.
+     * \verbatim cvlc a.ts --sout '#std{access=udp,mux=ts,dst=127.0.0.1:1234}' \endverbatim
+     * and likewise to port 1235, set both as standby sources and switch back
+     * and forth: picture and sound have to follow immediately, and stopping
+     * one of the streams has to show in state() after switching to it.
+     *
+     * \returns \c false if \p url is not in standby, nothing changes then
+     */
+    Q_INVOKABLE bool switchToStandbySource(const QUrl &url);
+
+    /**
+     * Backend extension: loops the current and all following sources until
+     * disabled. The input stays open and seeks back in the demuxer at the
+     * end, so there is no reopen and no gap. While looping neither
+     * aboutToFinish() nor finished() are emitted.
+     *
+     * Enabling looping on an already playing source restarts it with the same
+     * Media once at the end, disabling it makes the source end at its next
+     * wrap around.
+     */
+    Q_INVOKABLE bool isLooping() const;
+    Q_INVOKABLE void setLooping(bool looping);
+
+    /**
+     * Backend extension: repeatedly plays the region between \p start and
+     * \p end (in milliseconds) of the current source. The region is kept
+     * when the source is played again and cleared by setSource().
+     *
+     * The bounds are handed to the demuxer, which stops at the end of the
+     * region and seeks back to its start, so they hold regardless of stalls.
+     * A region set or cleared while playing reopens the source once, which
+     * costs a short gap. Not supported for streams.
+     */
+    Q_INVOKABLE void setLoopRegion(qint64 start, qint64 end);
+    Q_INVOKABLE void clearLoopRegion();
+
+    /**
+     * Tells whether the video sink \p sink is visible to the user. Once all
+     * video sinks stayed invisible for a while the video elementary stream is
+     * deselected, so only audio gets decoded, until one of them becomes
+     * visible again. Sinks are forgotten with removeSink().
+     */
+    void setVideoSinkVisible(SinkNode *sink, bool visible);
+
+    /**
+     * \returns whether probing found the current source to have no video
+     * other than still images; video sinks then leave the video output off.
+     * Cover art is reported as ARTWORK_URL meta data instead.
+     */
+    bool isAudioOnly() const;
+
     qint32 prefinishMark() const override;
     void setPrefinishMark(qint32 msecToEnd) override;
 
@@ -247,8 +337,14 @@ private Q_SLOTS:
     /*** Update media duration time - see comment in CPP */
     void updateDuration(qint64 newDuration);
 
-    /** Retrieve meta data of a file (i.e ARTIST, TITLE, ALBUM, etc...). */
-    void updateMetaData();
+    /**
+     * Retrieve meta data of a file (i.e ARTIST, TITLE, ALBUM, etc...).
+     * Only the metas flagged in \p changedMetas are fetched from libVLC, the
+     * rest is served from m_metaCache.
+     *
+     * \param changedMetas bitmask of libvlc_meta_t, see Media::metaBit()
+     */
+    void updateMetaData(uint changedMetas);
     void updateState(MediaPlayer::State state);
 
     /** Called when the availability of video output changed */
@@ -259,7 +355,66 @@ private Q_SLOTS:
     /** Refreshes all MediaController descriptors if Video is present. */
     void refreshDescriptors();
 
+    /** Builds the CD track layout from the parsed disc. */
+    void onCdLayoutParsed(int status);
+
+    /** Decides from the probed tracks whether the source is audio only. */
+    void onTrackProbeParsed(int status);
+
+    /** Gives up on a track probe that did not end in time, video stays on. */
+    void onTrackProbeTimeout();
+
+    /** Handles the end of the current track while playing a whole CD. */
+    void cdTrackEnded();
+
+    /** Stops video decoding, all video sinks have been invisible for a while. */
+    void suspendVideo();
+
 private:
+    /// Connects the MediaPlayer signals to this object.
+    void connectPlayer();
+
+    /// Schedules or undoes video suspension according to sink visibility.
+    void updateVideoSuspension();
+    void resumeVideo();
+
+    /**
+     * Starts reading the track layout of the current CD. Once it is known
+     * the whole disc is played as one input, making tracks mere positions
+     * in it: track changes are seeks and autoplay is gapless.
+     */
+    void requestCdLayout();
+
+    /**
+     * Configures m_media for the CD. Spans the whole disc if the layout
+     * is known, otherwise plays only \p track.
+     */
+    void setupCdMedia(int track);
+
+    /// \returns start and end of \p track on the disc, in milliseconds
+    qint64 cdTrackStart(int track) const;
+    qint64 cdTrackEnd(int track) const;
+
+    /// Makes \p track the current one, the player is expected to be there.
+    void startCdTrack(int track);
+
+    void changeCdTrack(int track) override;
+
+    /**
+     * Starts a quick local parse of the current source to find out whether
+     * it has any actual video, so video sinks can skip setting up a video
+     * output for audio files (including ones with cover art). play() waits
+     * for it, so the decision is made before the media is set up.
+     */
+    void requestTrackProbe();
+    void abortTrackProbe();
+
+    /**
+     * \returns whether the current source is a local file that was not
+     * probed yet while video sinks are connected.
+     */
+    bool needsTrackProbe() const;
+
     /**
      * This method actually calls the functions needed to begin playing the media.
      * If another media is already playing, it is discarded. The new media filename is set
@@ -282,6 +437,9 @@ private:
 
     bool hasNextTrack();
 
+    /// Reopens a running source so a changed loop region takes effect.
+    void reloadLoopRegion();
+
     /**
      * Changes the current state to buffering and sets the new current file.
      *
@@ -316,18 +474,58 @@ private:
 
     qint32 m_tickInterval;
     qint64 m_lastTick;
+    qint64 m_lastTime;
     qint32 m_transitionTime;
 
     Media *m_media;
+    StandbyPool *m_standbyPool;
+
+    bool m_looping;
+    /// Whether the current Media was set up with input-repeat.
+    bool m_mediaRepeats;
+    /// Loop region in milliseconds, -1 without one.
+    qint64 m_loopStart;
+    qint64 m_loopEnd;
+
+    /// Media listing the tracks of the CD while its layout is being read.
+    Media *m_cdLayoutMedia;
+    /// Start sector of every track plus the end of the last one.
+    QList<int> m_cdTrackSectors;
+    /// Whether the current Media spans the whole CD.
+    bool m_cdSpanning;
+    /**
+     * Whether a seek within the spanning CD did not land yet. Time updates
+     * from before it still report the old position and must not be taken
+     * for the end of the new track.
+     */
+    bool m_cdSeekPending;
+    QTimer *m_cdTrackEndTimer;
+
+    /// Media of the current source while its tracks are being probed.
+    Media *m_trackProbeMedia;
+    QTimer *m_trackProbeTimer;
+    /// Whether the track probe of the current source ended, in any way.
+    bool m_tracksProbed;
+    bool m_audioOnly;
+    /// Whether play() is waiting for the CD layout or the track probe.
+    bool m_playPending;
 
     qint64 m_totalTime;
     QByteArray m_mrl;
     QMultiMap<QString, QString> m_vlcMetaData;
+    /// Raw libVLC meta values of the current media, indexed by libvlc_meta_t.
+    QHash<int, QString> m_metaCache;
     QList<SinkNode *> m_sinks;
 
     bool m_hasVideo;
     bool m_isScreen;
 
+    QSet<SinkNode *> m_videoSinks;
+    QSet<SinkNode *> m_visibleVideoSinks;
+    QTimer *m_videoSuspendTimer;
+    /// Whether video is deselected because no sink is visible.
+    bool m_videoSuspended;
+
     /**
      * Workaround for being able to seek before VLC goes to playing state.
      * Seeks before playing are stored in this var, and processed on state change
@@ -0,0 +1,269 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mediaparser.h"
+
+#include <vlc/vlc.h>
+
+#include "utils/debug.h"
+#include "utils/libvlc.h"
+#include "media.h"
+
+namespace Phonon {
+namespace VLC {
+
+MediaParser::MediaParser(QObject *parent)
+    : QObject(parent)
+    , m_maximumConcurrency(LibVLC::self ? LibVLC::self->preparseThreads() : 1)
+    , m_nextBatchId(1)
+{
+}
+
+MediaParser::~MediaParser()
+{
+    cancelAll();
+}
+
+int MediaParser::parse(const QStringList &mrls, int timeout, bool network)
+{
+    const int batchId = m_nextBatchId++;
+    debug() << "queuing" << mrls.size() << "medias for parsing as batch" << batchId;
+
+    foreach (const QString &mrl, mrls) {
+        Request request;
+        request.batchId = batchId;
+        request.mrl = mrl;
+        request.timeout = timeout;
+        request.network = network;
+        m_pending.enqueue(request);
+    }
+
+    startPending();
+    // An empty batch is instantly done, queue it so the caller gets a chance
+    // to connect before the signal fires.
+    if (mrls.isEmpty())
+        QMetaObject::invokeMethod(this, "batchFinished", Qt::QueuedConnection, Q_ARG(int, batchId));
+    return batchId;
+}
+
+void MediaParser::cancel(int batchId)
+{
+    DEBUG_BLOCK;
+    bool live = false;
+    QMutableListIterator<Request> it(m_pending);
+    while (it.hasNext()) {
+        if (it.next().batchId == batchId) {
+            it.remove();
+            live = true;
+        }
+    }
+
+    // Stopping makes libvlc report the media as failed or skipped, the
+    // actual cleanup happens in onParsedChanged.
+    QHashIterator<Media *, Request> activeIt(m_active);
+    while (activeIt.hasNext()) {
+        activeIt.next();
+        if (activeIt.value().batchId == batchId) {
+            activeIt.key()->stopParse();
+            live = true;
+        }
+    }
+
+    // Unknown and already finished batches got their batchFinished().
+    if (live)
+        checkBatchFinished(batchId);
+}
+
+void MediaParser::cancelAll()
+{
+    m_pending.clear();
+    foreach (Media *media, m_active.keys()) {
+        media->disconnect(this);
+        media->stopParse();
+        media->deleteLater();
+    }
+    m_active.clear();
+}
+
+int MediaParser::maximumConcurrency() const
+{
+    return m_maximumConcurrency;
+}
+
+void MediaParser::setMaximumConcurrency(int concurrency)
+{
+    m_maximumConcurrency = qMax(1, concurrency);
+    startPending();
+}
+
+void MediaParser::startPending()
+{
+    while (m_active.size() < m_maximumConcurrency && !m_pending.isEmpty()) {
+        const Request request = m_pending.dequeue();
+
+        Media *media = new Media(request.mrl.toUtf8(), this);
+        connect(media, SIGNAL(parsedChanged(int)), this, SLOT(onParsedChanged(int)));
+        m_active.insert(media, request);
+
+        int flags = libvlc_media_parse_local | libvlc_media_fetch_local;
+        if (request.network)
+            flags |= libvlc_media_parse_network;
+        if (!media->parse(flags, request.timeout)) {
+            warning() << "failed to queue" << request.mrl << "for parsing";
+            m_active.remove(media);
+            media->deleteLater();
+            emit parsed(request.batchId,
+                        resultFor(nullptr, request.mrl, libvlc_media_parsed_status_failed));
+            checkBatchFinished(request.batchId);
+        }
+    }
+}
+
+void MediaParser::checkBatchFinished(int batchId)
+{
+    foreach (const Request &request, m_pending) {
+        if (request.batchId == batchId)
+            return;
+    }
+    foreach (const Request &request, m_active) {
+        if (request.batchId == batchId)
+            return;
+    }
+    emit batchFinished(batchId);
+}
+
+void MediaParser::onParsedChanged(int status)
+{
+    Media *media = qobject_cast<Media *>(sender());
+    if (!media || !m_active.contains(media))
+        return;
+
+    // Status 0 is merely the reset of the status when a parse starts.
+    if (status == 0)
+        return;
+
+    const Request request = m_active.take(media);
+    media->disconnect(this);
+    media->deleteLater();
+
+    emit parsed(request.batchId, resultFor(media, request.mrl, status));
+
+    startPending();
+    checkBatchFinished(request.batchId);
+}
+
+static QString fourccToString(quint32 fourcc)
+{
+    char chars[4];
+    for (int i = 0; i < 4; ++i) {
+        chars[i] = static_cast<char>((fourcc >> (8 * i)) & 0xff);
+    }
+    return QString::fromLatin1(chars, 4).trimmed();
+}
+
+static QString trackTypeToString(libvlc_track_type_t type)
+{
+    switch (type) {
+    case libvlc_track_audio:
+        return QStringLiteral("audio");
+    case libvlc_track_video:
+        return QStringLiteral("video");
+    case libvlc_track_text:
+        return QStringLiteral("text");
+    case libvlc_track_unknown:
+        break;
+    }
+    return QStringLiteral("unknown");
+}
+
+static QString statusToString(int status)
+{
+    switch (status) {
+    case libvlc_media_parsed_status_skipped:
+        return QStringLiteral("skipped");
+    case libvlc_media_parsed_status_failed:
+        return QStringLiteral("failed");
+    case libvlc_media_parsed_status_timeout:
+        return QStringLiteral("timeout");
+    case libvlc_media_parsed_status_done:
+        return QStringLiteral("done");
+    }
+    return QStringLiteral("failed");
+}
+
+QVariantMap MediaParser::resultFor(Media *media, const QString &mrl, int status)
+{
+    QVariantMap result;
+    result.insert(QStringLiteral("mrl"), mrl);
+    result.insert(QStringLiteral("status"), statusToString(status));
+
+    if (!media || status != libvlc_media_parsed_status_done) {
+        result.insert(QStringLiteral("duration"), qint64(-1));
+        return result;
+    }
+
+    result.insert(QStringLiteral("duration"), media->duration());
+
+    struct MetaKey { libvlc_meta_t meta; const char *key; };
+    static const MetaKey metaKeys[] = {
+        { libvlc_meta_Title, "TITLE" },
+        { libvlc_meta_Artist, "ARTIST" },
+        { libvlc_meta_Album, "ALBUM" },
+        { libvlc_meta_Date, "DATE" },
+        { libvlc_meta_Genre, "GENRE" },
+        { libvlc_meta_TrackNumber, "TRACKNUMBER" },
+        { libvlc_meta_Description, "DESCRIPTION" },
+        { libvlc_meta_Copyright, "COPYRIGHT" },
+        { libvlc_meta_URL, "URL" },
+        { libvlc_meta_EncodedBy, "ENCODEDBY" }
+    };
+    QVariantMap metaData;
+    for (const MetaKey &metaKey : metaKeys) {
+        const QString value = media->meta(metaKey.meta);
+        if (!value.isEmpty())
+            metaData.insert(QLatin1String(metaKey.key), value);
+    }
+    result.insert(QStringLiteral("metaData"), metaData);
+
+    QVariantList tracks;
+    foreach (const MediaTrack &track, media->tracks()) {
+        QVariantMap map;
+        map.insert(QStringLiteral("type"), trackTypeToString(track.type));
+        map.insert(QStringLiteral("codec"), fourccToString(track.codec));
+        map.insert(QStringLiteral("codecDescription"),
+                   QString::fromUtf8(libvlc_media_get_codec_description(track.type, track.codec)));
+        map.insert(QStringLiteral("language"), track.language);
+        map.insert(QStringLiteral("description"), track.description);
+        map.insert(QStringLiteral("bitrate"), track.bitrate);
+        if (track.type == libvlc_track_video) {
+            map.insert(QStringLiteral("width"), track.width);
+            map.insert(QStringLiteral("height"), track.height);
+            if (track.frameRateDen > 0)
+                map.insert(QStringLiteral("frameRate"), qreal(track.frameRateNum) / track.frameRateDen);
+        } else if (track.type == libvlc_track_audio) {
+            map.insert(QStringLiteral("channels"), track.channels);
+            map.insert(QStringLiteral("rate"), track.rate);
+        }
+        tracks << map;
+    }
+    result.insert(QStringLiteral("tracks"), tracks);
+
+    return result;
+}
+
+} // namespace VLC
+} // namespace Phonon
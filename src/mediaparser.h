@@ -0,0 +1,121 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_VLC_MEDIAPARSER_H
+#define PHONON_VLC_MEDIAPARSER_H
+
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QQueue>
+#include <QtCore/QStringList>
+#include <QtCore/QVariant>
+
+namespace Phonon {
+namespace VLC {
+
+class Media;
+
+/** \brief Bulk pre-parse service
+ *
+ * Parses arbitrary MRLs without involving a MediaObject so applications can
+ * learn duration, meta data and track information of e.g. an entire playlist
+ * up front. Requests are grouped into batches; at most maximumConcurrency()
+ * medias are being parsed by libVLC at any given time, the remainder is
+ * queued. Every finished media is reported through parsed(), once a batch is
+ * drained batchFinished() is emitted.
+ *
+ * The parser is owned by the Backend and can be obtained through
+ * Backend::mediaParser(), all public API is invokable through the meta object.
+ *
+ * Results are QVariantMaps with the following keys:
+ * \li \c mrl the MRL as passed to parse()
+ * \li \c status "done", "failed", "timeout" or "skipped"
+ * \li \c duration in milliseconds, -1 if unknown
+ * \li \c metaData QVariantMap using the same keys as MediaObject meta data
+ * \li \c tracks QVariantList of QVariantMaps (type, codec, codecDescription,
+ *     language, description, bitrate, width, height, frameRate, channels, rate)
+ */
+class MediaParser : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MediaParser(QObject *parent = nullptr);
+    ~MediaParser();
+
+    /**
+     * Queues a list of MRLs for parsing.
+     *
+     * \param mrls the MRLs to parse, they are not altered in any way
+     * \param timeout per media timeout in milliseconds
+     * \param network whether network medias should be parsed as well
+     * \returns batch id to identify results and to cancel()
+     */
+    Q_INVOKABLE int parse(const QStringList &mrls, int timeout = 5000, bool network = true);
+
+    /**
+     * Drops all queued medias of a batch and aborts those being parsed.
+     * batchFinished() follows as for any batch, nothing is emitted for
+     * unknown or already finished batches.
+     */
+    Q_INVOKABLE void cancel(int batchId);
+
+    /// Cancels all batches.
+    Q_INVOKABLE void cancelAll();
+
+    /**
+     * \returns the number of medias handed to libVLC at a time, defaults to
+     * the number of threads libVLC parses with (LibVLC::preparseThreads()).
+     * Going beyond that gains nothing, the surplus waits in libVLC's queue
+     * rather than ours and can no longer be cancelled cheaply.
+     */
+    int maximumConcurrency() const;
+    Q_INVOKABLE void setMaximumConcurrency(int concurrency);
+
+Q_SIGNALS:
+    void parsed(int batchId, const QVariantMap &result);
+    void batchFinished(int batchId);
+
+private Q_SLOTS:
+    void onParsedChanged(int status);
+
+private:
+    struct Request
+    {
+        int batchId;
+        QString mrl;
+        int timeout;
+        bool network;
+    };
+
+    /// Starts queued requests until the concurrency limit is reached.
+    void startPending();
+
+    /// Emits batchFinished() if nothing of the batch is queued or active.
+    void checkBatchFinished(int batchId);
+
+    static QVariantMap resultFor(Media *media, const QString &mrl, int status);
+
+    QQueue<Request> m_pending;
+    QHash<Media *, Request> m_active;
+    int m_maximumConcurrency;
+    int m_nextBatchId;
+};
+
+} // namespace VLC
+} // namespace Phonon
+
+#endif // PHONON_VLC_MEDIAPARSER_H
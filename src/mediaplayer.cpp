@@ -17,11 +17,15 @@
 
 #include "mediaplayer.h"
 
+#include <atomic>
+
+#include <QtCore/QDeadlineTimer>
 #include <QtCore/QDebug>
 #include <QtCore/QDir>
 #include <QtCore/QMetaType>
 #include <QtCore/QString>
 #include <QtCore/QTemporaryFile>
+#include <QtCore/QThreadPool>
 #include <QtGui/QImage>
 
 #include <vlc/libvlc_version.h>
@@ -44,6 +48,10 @@
         Qt::QueuedConnection, \
         Q_ARG(MediaPlayer::State, __state))
 
+// Time in milliseconds lastTime() carries the time forward at most. Beyond
+// a few time event intervals the clock is likely stalled (e.g. buffering).
+static const qint64 MAX_TIME_EXTRAPOLATION = 1000;
+
 namespace Phonon {
 namespace VLC {
 
@@ -52,8 +60,15 @@ MediaPlayer::MediaPlayer(QObject *parent)
     , m_media(0)
     , m_player(libvlc_media_player_new(pvlc_libvlc))
     , m_doingPausedPlay(false)
+    , m_videoEnabled(true)
+    , m_disabledVideoTrack(-1)
     , m_volume(75)
     , m_fadeAmount(1.0f)
+    , m_snapshotPool(0)
+    , m_lastTimeGeneration(0)
+    , m_lastTime(-1)
+    , m_lastTimeStamp(0)
+    , m_lastTimeRunning(0)
 {
     Q_ASSERT(m_player);
 
@@ -99,12 +114,23 @@ MediaPlayer::MediaPlayer(QObject *parent)
 
 MediaPlayer::~MediaPlayer()
 {
+    // Running snapshots use the player. Results queued to us after this are
+    // discarded along with the object.
+    if (m_snapshotPool)
+        m_snapshotPool->waitForDone();
     libvlc_media_player_release(m_player);
 }
 
 void MediaPlayer::setMedia(Media *media)
 {
     m_media = media;
+    // libvlc selects tracks anew for every media.
+    m_videoEnabled = true;
+    m_disabledVideoTrack = -1;
+    {
+        QMutexLocker lock(&m_lastTimeMutex);
+        writeLastTime(-1, false);
+    }
     libvlc_media_player_set_media(m_player, *m_media);
 }
 
@@ -169,16 +195,117 @@ void MediaPlayer::setTime(qint64 newTime)
 #endif
 }
 
+qint64 MediaPlayer::lastTime() const
+{
+    quint32 generation;
+    qint64 time;
+    qint64 stamp;
+    bool running;
+    do {
+        generation = m_lastTimeGeneration.loadAcquire();
+        time = m_lastTime.loadRelaxed();
+        stamp = m_lastTimeStamp.loadRelaxed();
+        running = m_lastTimeRunning.loadRelaxed();
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((generation & 1) || generation != m_lastTimeGeneration.loadRelaxed());
+
+    if (time < 0 || !running)
+        return time;
+    const qint64 elapsed = (QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs() - stamp) / 1000000;
+    return time + qBound<qint64>(0, elapsed, MAX_TIME_EXTRAPOLATION);
+}
+
+void MediaPlayer::storeLastTime(qint64 time)
+{
+    QMutexLocker lock(&m_lastTimeMutex);
+    writeLastTime(time, m_lastTimeRunning.loadRelaxed());
+}
+
+void MediaPlayer::setLastTimeRunning(bool running)
+{
+    QMutexLocker lock(&m_lastTimeMutex);
+    if (running == bool(m_lastTimeRunning.loadRelaxed()))
+        return;
+    // Pause at, or resume from, wherever the time got to.
+    writeLastTime(lastTime(), running);
+}
+
+void MediaPlayer::writeLastTime(qint64 time, bool running)
+{
+    // m_lastTimeMutex is held, see lastTime() for the reading side.
+    const quint32 generation = m_lastTimeGeneration.loadRelaxed();
+    m_lastTimeGeneration.storeRelaxed(generation + 1);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_lastTime.storeRelaxed(time);
+    m_lastTimeStamp.storeRelaxed(QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs());
+    m_lastTimeRunning.storeRelaxed(running);
+    m_lastTimeGeneration.storeRelease(generation + 2);
+}
+
 bool MediaPlayer::isSeekable() const
 {
     return libvlc_media_player_is_seekable(m_player);
 }
 
+MediaPlayer::State MediaPlayer::state() const
+{
+    switch (libvlc_media_player_get_state(m_player)) {
+    case libvlc_NothingSpecial:
+        return NoState;
+    case libvlc_Opening:
+        return OpeningState;
+    case libvlc_Buffering:
+        return BufferingState;
+    case libvlc_Playing:
+        return PlayingState;
+    case libvlc_Paused:
+        return PausedState;
+    case libvlc_Stopped:
+        return StoppedState;
+#if (LIBVLC_VERSION_INT >= LIBVLC_VERSION(4, 0, 0, 0))
+    case libvlc_Stopping:
+        return StoppedState;
+#else
+    case libvlc_Ended:
+        return EndedState;
+#endif
+    case libvlc_Error:
+        return ErrorState;
+    }
+    return NoState;
+}
+
 bool MediaPlayer::hasVideoOutput() const
 {
     return libvlc_media_player_has_vout(m_player) > 0;
 }
 
+void MediaPlayer::setVideoEnabled(bool enabled)
+{
+    if (enabled == m_videoEnabled)
+        return;
+    m_videoEnabled = enabled;
+
+    if (!enabled) {
+        const int current = libvlc_video_get_track(m_player);
+        if (current >= 0)
+            m_disabledVideoTrack = current;
+        libvlc_video_set_track(m_player, -1);
+        return;
+    }
+
+    int track = m_disabledVideoTrack;
+    if (track < 0) {
+        // Never had a track selected, pick the first real one (-1 is "Disable").
+        VLC_FOREACH_TRACK(it, libvlc_video_get_track_description(m_player)) {
+            if (track < 0 && it->i_id >= 0)
+                track = it->i_id;
+        }
+    }
+    if (track >= 0)
+        libvlc_video_set_track(m_player, track);
+}
+
 bool MediaPlayer::setSubtitle(int subtitle)
 {
     return libvlc_video_set_spu(m_player, subtitle) == 0;
@@ -203,17 +330,49 @@ void MediaPlayer::setChapter(int chapter)
 }
 
 QImage MediaPlayer::snapshot() const
+{
+    return takeSnapshot(m_player);
+}
+
+void MediaPlayer::requestSnapshot()
+{
+    if (!m_snapshotPool) {
+        m_snapshotPool = new QThreadPool(this);
+        m_snapshotPool->setMaxThreadCount(1);
+    }
+    libvlc_media_player_t *player = m_player;
+    m_snapshotPool->start([this, player]() {
+        const QImage image = takeSnapshot(player);
+        QMetaObject::invokeMethod(this, "snapshotTaken", Qt::QueuedConnection,
+                                  Q_ARG(QImage, image));
+    });
+}
+
+QImage MediaPlayer::takeSnapshot(libvlc_media_player_t *player)
 {
     QTemporaryFile tempFile(QDir::tempPath() % QDir::separator() % QStringLiteral("phonon-vlc-snapshot"));
     tempFile.open();
 
-    // This function is sync.
-    if (libvlc_video_take_snapshot(m_player, 0, tempFile.fileName().toLocal8Bit().data(), 0, 0) != 0)
+    // This function is sync, it encodes and writes a PNG.
+    if (libvlc_video_take_snapshot(player, 0, tempFile.fileName().toLocal8Bit().data(), 0, 0) != 0)
         return QImage();
 
     return QImage(tempFile.fileName());
 }
 
+void MediaPlayer::setMarqueeText(const QString &text)
+{
+    if (text.isEmpty()) {
+        libvlc_video_set_marquee_int(m_player, libvlc_marquee_Enable, 0);
+        return;
+    }
+    libvlc_video_set_marquee_string(m_player, libvlc_marquee_Text, text.toUtf8().constData());
+    // Top left, in the same place the surface painter draws it.
+    libvlc_video_set_marquee_int(m_player, libvlc_marquee_Position, 4 | 1);
+    libvlc_video_set_marquee_int(m_player, libvlc_marquee_Timeout, 0);
+    libvlc_video_set_marquee_int(m_player, libvlc_marquee_Enable, 1);
+}
+
 bool MediaPlayer::setAudioTrack(int track)
 {
     return libvlc_audio_set_track(m_player, track) == 0;
@@ -227,6 +386,7 @@ void MediaPlayer::event_cb(const libvlc_event_t *event, void *opaque)
     // Do not forget to register for the events you want to handle here!
     switch (event->type) {
     case libvlc_MediaPlayerTimeChanged:
+        that->storeLastTime(event->u.media_player_time_changed.new_time);
         QMetaObject::invokeMethod(
                     that, "timeChanged",
                     Qt::QueuedConnection,
@@ -273,19 +433,25 @@ void MediaPlayer::event_cb(const libvlc_event_t *event, void *opaque)
             } else {
                 QMetaObject::invokeMethod(that, "stop", Qt::QueuedConnection);
             }
-        } else
+        } else {
+            that->setLastTimeRunning(true);
             P_EMIT_STATE(PlayingState);
+        }
         break;
     case libvlc_MediaPlayerPaused:
+        that->setLastTimeRunning(false);
         P_EMIT_STATE(PausedState);
         break;
     case libvlc_MediaPlayerStopped:
+        that->setLastTimeRunning(false);
         P_EMIT_STATE(StoppedState);
         break;
     case libvlc_MediaPlayerEndReached:
+        that->setLastTimeRunning(false);
         P_EMIT_STATE(EndedState);
         break;
     case libvlc_MediaPlayerEncounteredError:
+        that->setLastTimeRunning(false);
         P_EMIT_STATE(ErrorState);
         break;
     case libvlc_MediaPlayerVout:
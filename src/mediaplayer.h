@@ -18,6 +18,8 @@
 #ifndef PHONON_VLC_MEDIAPLAYER_H
 #define PHONON_VLC_MEDIAPLAYER_H
 
+#include <QAtomicInteger>
+#include <QMutex>
 #include <QObject>
 #include <QSharedPointer>
 #include <QSize>
@@ -27,6 +29,7 @@
 
 class QImage;
 class QString;
+class QThreadPool;
 
 namespace Phonon {
 namespace VLC {
@@ -90,6 +93,7 @@ public:
     inline operator libvlc_media_player_t *() const { return m_player; }
 
     void setMedia(Media *media);
+    inline Media *media() const { return m_media; }
 
     void setVideoCallbacks();
     void setVideoFormatCallbacks();
@@ -110,8 +114,21 @@ public:
     qint64 time() const;
     void setTime(qint64 newTime);
 
+    /**
+     * \returns the current time as of the last time changed event, carried
+     * forward on the monotonic clock while playing; -1 before the first one.
+     * libvlc only sends time events every 250 ms or so, this tells apart the
+     * frames in between. Unlike time() it does not call into libvlc nor take
+     * a lock, so it is safe to use from the vout callbacks, where time() may
+     * deadlock with the player.
+     */
+    qint64 lastTime() const;
+
     bool isSeekable() const;
 
+    /// \returns the current state as stateChanged() would report it
+    State state() const;
+
     // Video
     QSize videoSize() const
     {
@@ -123,6 +140,14 @@ public:
 
     bool hasVideoOutput() const;
 
+    /**
+     * Enables or disables decoding of video by (de)selecting the video
+     * elementary stream. The input stays open, re-enabling restores the
+     * previously selected track.
+     */
+    void setVideoEnabled(bool enabled);
+    bool isVideoEnabled() const { return m_videoEnabled; }
+
     /// Set new video aspect ratio.
     /// \param aspect new video aspect-ratio or empty to reset to default
     void setVideoAspectRatio(const QByteArray &aspect)
@@ -134,6 +159,9 @@ public:
     void setVideoAdjust(libvlc_video_adjust_option_t adjust, float value)
     { libvlc_video_set_adjust_float(m_player, adjust, value); }
 
+    /// Shows \p text in the top left corner of the video, an empty text hides it.
+    void setMarqueeText(const QString &text);
+
     int subtitle() const
     { return libvlc_video_get_spu(m_player); }
 
@@ -180,9 +208,18 @@ public:
 
     void setChapter(int chapter);
 
-    /** Reentrant, through libvlc */
+    /**
+     * Reentrant, through libvlc. Blocks until libVLC wrote and we read back
+     * a PNG, prefer requestSnapshot().
+     */
     QImage snapshot() const;
 
+    /**
+     * Takes a snapshot like snapshot(), but on a worker thread. The result is
+     * delivered through snapshotTaken(), a null image if it failed.
+     */
+    void requestSnapshot();
+
     // Audio
     /// Get current audio volume.
     /// \return the software volume in percents (0 = mute, 100 = nominal / 0dB)
@@ -242,8 +279,18 @@ Q_SIGNALS:
     void mutedChanged(bool mute);
     void volumeChanged(float volume);
 
+    void snapshotTaken(const QImage &image);
+
 private:
     static void event_cb(const libvlc_event_t *event, void *opaque);
+
+    /// Records \p time as of now for lastTime(), from any thread.
+    void storeLastTime(qint64 time);
+    /// Starts or stops carrying lastTime() forward, from any thread.
+    void setLastTimeRunning(bool running);
+    /// Writes the state of lastTime(), m_lastTimeMutex must be held.
+    void writeLastTime(qint64 time, bool running);
+    static QImage takeSnapshot(libvlc_media_player_t *player);
     void setVolumeInternal();
 
     Media *m_media;
@@ -251,8 +298,24 @@ private:
     libvlc_media_player_t *m_player;
 
     bool m_doingPausedPlay;
+    bool m_videoEnabled;
+    int m_disabledVideoTrack;
     int m_volume;
     qreal m_fadeAmount;
+
+    /// Runs snapshot requests, created on first use.
+    QThreadPool *m_snapshotPool;
+
+    /**
+     * Seqlock around the state of lastTime(), the generation is odd while
+     * being written. Writers serialize on m_lastTimeMutex, readers retry.
+     */
+    QMutex m_lastTimeMutex;
+    QAtomicInteger<quint32> m_lastTimeGeneration;
+    QAtomicInteger<qint64> m_lastTime;
+    /// When m_lastTime was current, on QElapsedTimer's clock in nanoseconds.
+    QAtomicInteger<qint64> m_lastTimeStamp;
+    QAtomicInt m_lastTimeRunning;
 };
 
 QDebug operator<<(QDebug dbg, const MediaPlayer::State &s);
@@ -64,6 +64,15 @@ public:
      */
     void addToMedia(Media *media);
 
+    /**
+     * \returns whether this sink outputs video. The MediaObject probes the
+     * tracks of local sources before playing them to video sinks, so those
+     * can leave the video output off for audio only sources.
+     *
+     * \see MediaObject::isAudioOnly()
+     */
+    virtual bool isVideoSink() const { return false; }
+
 protected:
     /**
      * Handling function for derived classes.
@@ -0,0 +1,212 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "standbypool.h"
+
+#include <QtCore/QByteArray>
+
+#include "utils/debug.h"
+#include "video/videomemorystream.h"
+#include "media.h"
+#include "mediaplayer.h"
+
+namespace Phonon {
+namespace VLC {
+
+/**
+ * Swallows all frames of a standby player. Lives as child of the player so
+ * it is only destroyed once the player (and with it the vout) is gone.
+ */
+class DiscardingVideoSink : public QObject, public VideoMemoryStream
+{
+public:
+    explicit DiscardingVideoSink(MediaPlayer *player)
+        : QObject(player)
+        , m_planeCount(0)
+    {
+        setCallbacks(player);
+    }
+
+private:
+    void *lockCallback(void **planes) override
+    {
+        char *data = m_buffer.data();
+        for (int i = 0; i < m_planeCount; ++i) {
+            planes[i] = data;
+            data += m_planeSizes[i];
+        }
+        return nullptr;
+    }
+
+    void unlockCallback(void *picture, void *const *planes) override
+    {
+        Q_UNUSED(picture);
+        Q_UNUSED(planes);
+    }
+
+    void displayCallback(void *picture) override
+    {
+        Q_UNUSED(picture);
+    }
+
+    unsigned formatCallback(char *chroma,
+                            unsigned *width, unsigned *height,
+                            unsigned *pitches,
+                            unsigned *lines) override
+    {
+        // Keep whatever the decoder outputs, there is no point in converting.
+        const vlc_fourcc_t fourcc = VLC_FOURCC(chroma[0], chroma[1], chroma[2], chroma[3]);
+        const unsigned bufferSize = setPitchAndLines(fourcc, *width, *height, pitches, lines);
+        m_planeCount = 0;
+        for (; m_planeCount < PICTURE_PLANE_MAX && pitches[m_planeCount] != 0; ++m_planeCount) {
+            m_planeSizes[m_planeCount] = pitches[m_planeCount] * lines[m_planeCount];
+        }
+        m_buffer.resize(bufferSize);
+        return bufferSize;
+    }
+
+    void formatCleanUpCallback() override
+    {
+    }
+
+    QByteArray m_buffer;
+    unsigned m_planeSizes[PICTURE_PLANE_MAX];
+    int m_planeCount;
+};
+
+StandbyPool::StandbyPool(QObject *parent)
+    : QObject(parent)
+{
+}
+
+StandbyPool::~StandbyPool()
+{
+    foreach (const Entry &entry, m_entries) {
+        dispose(entry);
+    }
+}
+
+void StandbyPool::setSources(const QList<QUrl> &urls)
+{
+    DEBUG_BLOCK;
+    m_urls = urls.mid(0, maximumSize);
+
+    QMutableListIterator<Entry> it(m_entries);
+    while (it.hasNext()) {
+        const Entry &entry = it.next();
+        if (!m_urls.contains(entry.url)) {
+            dispose(entry);
+            it.remove();
+        }
+    }
+
+    foreach (const QUrl &url, m_urls) {
+        bool known = false;
+        foreach (const Entry &entry, m_entries) {
+            known = known || entry.url == url;
+        }
+        if (known)
+            continue;
+
+        debug() << "starting standby player for" << url;
+        Entry entry;
+        entry.url = url;
+        entry.player = new MediaPlayer(this);
+        entry.media = new Media(url.toEncoded(), this);
+        // Both ES categories are needed so they can be selected on promotion,
+        // the instance defaults disable them.
+        entry.media->addOption(QLatin1String(":audio"));
+        entry.media->addOption(QLatin1String(":video"));
+        putInStandby(entry.player);
+        entry.player->setMedia(entry.media);
+        entry.player->play();
+        m_entries << entry;
+    }
+}
+
+QList<QUrl> StandbyPool::sources() const
+{
+    return m_urls;
+}
+
+StandbyPool::Entry StandbyPool::take(const QUrl &url)
+{
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries.at(i).url != url)
+            continue;
+        const Entry entry = m_entries.takeAt(i);
+        entry.player->disconnect(this);
+        // The discarding sink stays as a child of the player, the promoting
+        // sinks override the vout through their own callbacks/drawables.
+        return entry;
+    }
+    return Entry();
+}
+
+void StandbyPool::adopt(const QUrl &url, Media *media, MediaPlayer *player)
+{
+    Entry entry;
+    entry.url = url;
+    entry.media = media;
+    entry.player = player;
+
+    if (!m_urls.contains(url)) {
+        dispose(entry);
+        return;
+    }
+
+    debug() << "returning" << url << "to standby";
+    media->setParent(this);
+    player->setParent(this);
+    putInStandby(player);
+    player->setVideoEnabled(false);
+    m_entries << entry;
+}
+
+void StandbyPool::putInStandby(MediaPlayer *player)
+{
+    player->setMute(true);
+    if (!player->findChild<DiscardingVideoSink *>())
+        new DiscardingVideoSink(player);
+    else
+        player->findChild<DiscardingVideoSink *>()->setCallbacks(player);
+    connect(player, SIGNAL(hasVideoChanged(bool)), this, SLOT(onHasVideoChanged(bool)));
+}
+
+void StandbyPool::onHasVideoChanged(bool hasVideo)
+{
+    // Video got selected by libvlc's ES policy, once the vout is up we know
+    // the ES is there and deselect it to stop decoding.
+    MediaPlayer *player = qobject_cast<MediaPlayer *>(sender());
+    if (player && hasVideo)
+        player->setVideoEnabled(false);
+}
+
+void StandbyPool::dispose(const Entry &entry)
+{
+    if (entry.player) {
+        entry.player->disconnect();
+        entry.player->deleteLater();
+    }
+    if (entry.media) {
+        entry.media->disconnect();
+        entry.media->deleteLater();
+    }
+}
+
+} // namespace VLC
+} // namespace Phonon
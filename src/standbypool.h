@@ -0,0 +1,94 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_VLC_STANDBYPOOL_H
+#define PHONON_VLC_STANDBYPOOL_H
+
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QUrl>
+
+namespace Phonon {
+namespace VLC {
+
+class Media;
+class MediaPlayer;
+
+/** \brief Pool of pre-buffered standby players for fast source switching
+ *
+ * Opening a live source (UDP/HTTP TS, etc.) costs a full open, probe and
+ * network buffering. The pool keeps a MediaPlayer per standby source running,
+ * muted and with the video elementary stream deselected, so the input stays
+ * open and buffered. MediaObject::switchToStandbySource() then promotes one of
+ * them to the visible and audible output.
+ *
+ * Until video is deselected frames of standby players are discarded through
+ * a memory sink so no stray window is ever created.
+ */
+class StandbyPool : public QObject
+{
+    Q_OBJECT
+public:
+    struct Entry
+    {
+        Entry() : media(nullptr), player(nullptr) {}
+        QUrl url;
+        Media *media;
+        MediaPlayer *player;
+    };
+
+    explicit StandbyPool(QObject *parent = nullptr);
+    ~StandbyPool();
+
+    /**
+     * Replaces the set of standby sources. Players of sources that remain in
+     * the set are kept running, others are stopped.
+     */
+    void setSources(const QList<QUrl> &urls);
+    QList<QUrl> sources() const;
+
+    /**
+     * Removes the standby entry for \p url from the pool and hands ownership
+     * of its player and media to the caller.
+     * \returns the entry, with null pointers if there is no such entry
+     */
+    Entry take(const QUrl &url);
+
+    /**
+     * Puts an already running player back into standby. Ownership is taken.
+     * If \p url is not a standby source the player is disposed of instead.
+     */
+    void adopt(const QUrl &url, Media *media, MediaPlayer *player);
+
+    /// Maximum amount of standby players, further sources are ignored.
+    static const int maximumSize = 4;
+
+private Q_SLOTS:
+    void onHasVideoChanged(bool hasVideo);
+
+private:
+    void putInStandby(MediaPlayer *player);
+    static void dispose(const Entry &entry);
+
+    QList<Entry> m_entries;
+    QList<QUrl> m_urls;
+};
+
+} // namespace VLC
+} // namespace Phonon
+
+#endif // PHONON_VLC_STANDBYPOOL_H
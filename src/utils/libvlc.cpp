@@ -24,6 +24,7 @@
 #include <QtCore/QSettings>
 #include <QtCore/QString>
 #include <QtCore/QStringBuilder>
+#include <QtCore/QThread>
 #include <QtCore/QVarLengthArray>
 
 #include <phonon/pulsesupport.h>
@@ -37,6 +38,8 @@ LibVLC *LibVLC::self;
 
 LibVLC::LibVLC()
     : m_vlcInstance(0)
+    , m_statistics(false)
+    , m_preparseThreads(1)
 {
 }
 
@@ -79,8 +82,16 @@ bool LibVLC::init()
     }
 
     args << "--no-media-library";
+    // libvlc parses with a single thread by default, so a MediaParser batch
+    // would hold up everything else, including the track probe before play.
+    self->m_preparseThreads = qBound(2, QThread::idealThreadCount(), 4);
+    args << QByteArray("--preparse-threads=").append(QByteArray::number(self->m_preparseThreads));
     args << "--no-osd";
-    args << "--no-stats";
+    // Statistics cost a bit on every block and picture, only collect them
+    // for the performance overlay (see VideoWidget::setPerformanceOverlay).
+    self->m_statistics = qEnvironmentVariableIntValue("PHONON_VLC_OVERLAY") != 0;
+    if (!self->m_statistics)
+        args << "--no-stats";
     // By default VLC will put a picture-in-picture when making a snapshot.
     // This is unexpected behaviour for us, so we force it off.
     args << "--no-snapshot-preview";
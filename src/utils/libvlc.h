@@ -107,6 +107,24 @@ public:
         return m_vlcInstance;
     }
 
+    /**
+     * \returns whether libvlc collects input and decoder statistics, only
+     * then libvlc_media_get_stats() reports anything but zeros
+     */
+    bool hasStatistics() const
+    {
+        return m_statistics;
+    }
+
+    /**
+     * \returns the number of threads libvlc parses medias with, parse
+     * requests beyond that wait in libvlc's queue
+     */
+    int preparseThreads() const
+    {
+        return m_preparseThreads;
+    }
+
     /**
      * Construct singleton and initialize and launch the VLC library.
      *
@@ -135,6 +153,8 @@ private:
     LibVLC();
 
     libvlc_instance_t *m_vlcInstance;
+    bool m_statistics;
+    int m_preparseThreads;
 };
 
 #endif // LIBVLC_H
@@ -0,0 +1,162 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "prefetcher.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QMutexLocker>
+
+#if defined(Q_OS_UNIX)
+#include <fcntl.h>
+#endif
+
+#include "debug.h"
+
+// Container headers and the index of most files are well within that range.
+// Files with trailing indexes (mp4 moov, avi idx1, mkv cues) also need their
+// tail.
+#define DEFAULT_HEAD_KIB 4096
+#define DEFAULT_TAIL_KIB 1024
+
+// Amount of recently warmed files to remember.
+#define MAX_WARMED 16
+
+namespace Phonon {
+namespace VLC {
+
+Prefetcher::Prefetcher(QObject *parent)
+    : QThread(parent)
+    , m_headSize(DEFAULT_HEAD_KIB * 1024)
+    , m_tailSize(DEFAULT_TAIL_KIB * 1024)
+    , m_quit(false)
+{
+    bool ok = false;
+    const int sizeKiB = qgetenv("PHONON_VLC_PREFETCH_SIZE").toInt(&ok);
+    if (ok && sizeKiB >= 0) {
+        m_headSize = qint64(sizeKiB) * 1024;
+        m_tailSize = m_headSize / 4;
+    }
+}
+
+Prefetcher::~Prefetcher()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_quit = true;
+        m_queue.clear();
+        m_waitCondition.wakeAll();
+    }
+    wait();
+}
+
+void Prefetcher::prefetch(const QStringList &files)
+{
+    if (m_headSize <= 0)
+        return;
+
+    QMutexLocker lock(&m_mutex);
+    m_queue.clear();
+    foreach (const QString &file, files) {
+        if (!m_warmed.contains(file) && !m_queue.contains(file))
+            m_queue << file;
+    }
+    if (m_queue.isEmpty())
+        return;
+
+    if (!isRunning())
+        start(QThread::LowestPriority);
+    m_waitCondition.wakeAll();
+}
+
+void Prefetcher::prefetchNext(const QString &file)
+{
+    if (m_headSize <= 0)
+        return;
+
+    QMutexLocker lock(&m_mutex);
+    if (m_warmed.contains(file))
+        return;
+    m_queue.removeAll(file);
+    m_queue.prepend(file);
+
+    if (!isRunning())
+        start(QThread::LowestPriority);
+    m_waitCondition.wakeAll();
+}
+
+void Prefetcher::run()
+{
+    forever {
+        QString file;
+        {
+            QMutexLocker lock(&m_mutex);
+            while (m_queue.isEmpty() && !m_quit)
+                m_waitCondition.wait(&m_mutex);
+            if (m_quit)
+                return;
+            file = m_queue.takeFirst();
+            m_warmed << file;
+            while (m_warmed.size() > MAX_WARMED)
+                m_warmed.removeFirst();
+        }
+        warm(file);
+    }
+}
+
+void Prefetcher::warm(const QString &file)
+{
+    QFile handle(file);
+    if (!handle.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        debug() << "not prefetching" << file << handle.errorString();
+        return;
+    }
+
+    const qint64 size = handle.size();
+    const qint64 headLength = qMin(size, m_headSize);
+    const qint64 tailOffset = qMax(headLength, size - m_tailSize);
+    const qint64 tailLength = size - tailOffset;
+
+    debug() << "prefetching" << file << headLength << "+" << tailLength << "bytes";
+
+#if defined(Q_OS_LINUX)
+    // readahead blocks until the data is in the page cache, which is
+    // exactly what we want on this thread.
+    ::readahead(handle.handle(), 0, headLength);
+    if (tailLength > 0)
+        ::readahead(handle.handle(), tailOffset, tailLength);
+#elif defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+    ::posix_fadvise(handle.handle(), 0, headLength, POSIX_FADV_WILLNEED);
+    if (tailLength > 0)
+        ::posix_fadvise(handle.handle(), tailOffset, tailLength, POSIX_FADV_WILLNEED);
+#else
+    // No advisory interface, simply read the data to get it cached.
+    QByteArray buffer(64 * 1024, Qt::Uninitialized);
+    qint64 done = 0;
+    while (done < headLength && !handle.atEnd()) {
+        const qint64 read = handle.read(buffer.data(), buffer.size());
+        if (read <= 0)
+            break;
+        done += read;
+    }
+    if (tailLength > 0 && handle.seek(tailOffset)) {
+        while (handle.read(buffer.data(), buffer.size()) > 0) {}
+    }
+#endif
+}
+
+} // namespace VLC
+} // namespace Phonon
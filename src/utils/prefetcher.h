@@ -0,0 +1,81 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_VLC_PREFETCHER_H
+#define PHONON_VLC_PREFETCHER_H
+
+#include <QtCore/QMutex>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+
+namespace Phonon {
+namespace VLC {
+
+/**
+ * \brief Warms the page cache for local files that are about to be played.
+ *
+ * Track changes on spinning disks or network mounts usually stall on the
+ * first reads of the container header and index. The Prefetcher reads the
+ * head and tail of upcoming local files on a low priority background thread
+ * (through readahead/posix_fadvise where available) so the actual open
+ * can be served from memory.
+ *
+ * The amount of data warmed per file can be tuned through the
+ * PHONON_VLC_PREFETCH_SIZE environment variable (in KiB, 0 disables).
+ */
+class Prefetcher : public QThread
+{
+    Q_OBJECT
+public:
+    explicit Prefetcher(QObject *parent = nullptr);
+    ~Prefetcher();
+
+    /**
+     * Replaces the queue of files to warm. Files that were warmed recently
+     * are skipped. Never blocks.
+     *
+     * \param files local file paths in order of expected playback
+     */
+    void prefetch(const QStringList &files);
+
+    /**
+     * Puts a single file in front of the queue, keeping the rest of it.
+     * Used for the next source handed to us by libphonon.
+     */
+    void prefetchNext(const QString &file);
+
+protected:
+    void run() override;
+
+private:
+    void warm(const QString &file);
+
+    QMutex m_mutex;
+    QWaitCondition m_waitCondition;
+    QStringList m_queue;
+    /// Most recently warmed files, oldest first. Bounded in size.
+    QStringList m_warmed;
+    qint64 m_headSize;
+    qint64 m_tailSize;
+    bool m_quit;
+};
+
+} // namespace VLC
+} // namespace Phonon
+
+#endif // PHONON_VLC_PREFETCHER_H
@@ -0,0 +1,67 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "latencystatistics.h"
+
+#include <algorithm>
+
+#include <QtCore/QDeadlineTimer>
+
+// Samples the percentiles are taken over, several seconds of video.
+#define LATENCY_WINDOW 256
+
+namespace Phonon {
+namespace VLC {
+
+LatencyStatistics::LatencyStatistics()
+    : m_next(0)
+{
+    m_samples.reserve(LATENCY_WINDOW);
+}
+
+void LatencyStatistics::add(qint64 latency)
+{
+    if (m_samples.size() < LATENCY_WINDOW) {
+        m_samples << latency;
+        return;
+    }
+    m_samples[m_next] = latency;
+    m_next = (m_next + 1) % LATENCY_WINDOW;
+}
+
+void LatencyStatistics::insertInto(QVariantMap *statistics, const QString &name) const
+{
+    if (m_samples.isEmpty())
+        return;
+
+    QVector<qint64> samples = m_samples;
+    static const int percentiles[] = { 50, 90, 99 };
+    for (const int percentile : percentiles) {
+        const auto nth = samples.begin() + (samples.size() - 1) * percentile / 100;
+        std::nth_element(samples.begin(), nth, samples.end());
+        statistics->insert(name + QString::number(percentile), *nth / 1000);
+    }
+}
+
+qint64 LatencyStatistics::now()
+{
+    // Same clock as QElapsedTimer, comparable across threads and objects.
+    return QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+}
+
+} // namespace VLC
+} // namespace Phonon
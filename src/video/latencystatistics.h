@@ -0,0 +1,60 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_VLC_LATENCYSTATISTICS_H
+#define PHONON_VLC_LATENCYSTATISTICS_H
+
+#include <QtCore/QString>
+#include <QtCore/QVariantMap>
+#include <QtCore/QVector>
+
+namespace Phonon {
+namespace VLC {
+
+/** \brief Latency percentiles over the most recent frames
+ *
+ * Keeps a fixed window of samples, so the figures follow changes in load.
+ * Not thread safe, callers guard it like the rest of their statistics.
+ */
+class LatencyStatistics
+{
+public:
+    LatencyStatistics();
+
+    /// Adds a sample, in nanoseconds.
+    void add(qint64 latency);
+
+    /**
+     * Inserts the median, 90th and 99th percentile as \p name50, \p name90
+     * and \p name99 into \p statistics, in microseconds. Nothing is inserted
+     * before the first sample.
+     */
+    void insertInto(QVariantMap *statistics, const QString &name) const;
+
+    /// \returns the monotonic clock timestamps and latencies are taken on, in nanoseconds
+    static qint64 now();
+
+private:
+    QVector<qint64> m_samples;
+    /// Next sample to overwrite once the window is full.
+    int m_next;
+};
+
+} // namespace VLC
+} // namespace Phonon
+
+#endif // PHONON_VLC_LATENCYSTATISTICS_H
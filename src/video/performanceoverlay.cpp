@@ -0,0 +1,112 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "performanceoverlay.h"
+
+#include <QtCore/QStringList>
+#include <QtGui/QFontDatabase>
+#include <QtGui/QPainter>
+
+#include "media.h"
+#include "mediaplayer.h"
+#include "utils/libvlc.h"
+
+// Padding around the text, in pixels.
+#define OVERLAY_MARGIN 6
+
+namespace Phonon {
+namespace VLC {
+
+/// \returns the per second rate of \p current - \p last over \p msecs
+static qreal rate(qint64 current, qint64 last, qint64 msecs)
+{
+    // Counters start over with every media.
+    return msecs > 0 ? qMax<qint64>(0, current - last) * 1000.0 / msecs : 0.0;
+}
+
+PerformanceOverlay::PerformanceOverlay()
+    : m_hasLastStats(false)
+{
+}
+
+void PerformanceOverlay::sample(MediaPlayer *player, const QVariantMap &frameStatistics, int bufferLevel)
+{
+    const qint64 msecs = m_sampleTimer.isValid() ? m_sampleTimer.restart() : 0;
+    if (!m_sampleTimer.isValid())
+        m_sampleTimer.start();
+
+    QStringList lines;
+
+    // Without statistics libVLC reports zeros, which would read as a stall.
+    libvlc_media_stats_t stats;
+    const bool hasStats = LibVLC::self->hasStatistics()
+            && player && player->media() && player->media()->stats(&stats);
+    if (hasStats) {
+        // f_input_bitrate is in bytes per millisecond.
+        lines << QStringLiteral("input %1 kbit/s").arg(qRound(stats.f_input_bitrate * 8000));
+        if (m_hasLastStats) {
+            lines << QStringLiteral("decoded %1 fps  displayed %2 fps  lost %3 fps")
+                     .arg(rate(stats.i_decoded_video, m_lastStats.i_decoded_video, msecs), 0, 'f', 1)
+                     .arg(rate(stats.i_displayed_pictures, m_lastStats.i_displayed_pictures, msecs), 0, 'f', 1)
+                     .arg(rate(stats.i_lost_pictures, m_lastStats.i_lost_pictures, msecs), 0, 'f', 1);
+        }
+        m_lastStats = stats;
+    }
+    m_hasLastStats = hasStats;
+
+    lines << QStringLiteral("buffer %1%").arg(bufferLevel);
+
+    if (!frameStatistics.isEmpty()) {
+        if (!m_lastFrameStatistics.isEmpty()) {
+            const auto frameRate = [&](const char *key) {
+                const QString name = QLatin1String(key);
+                return rate(frameStatistics.value(name).toLongLong(),
+                            m_lastFrameStatistics.value(name).toLongLong(), msecs);
+            };
+            lines << QStringLiteral("painted %1 fps  dropped %2 fps  late %3 fps")
+                     .arg(frameRate("painted"), 0, 'f', 1)
+                     .arg(frameRate("dropped"), 0, 'f', 1)
+                     .arg(frameRate("late"), 0, 'f', 1);
+        }
+        // Delay from VLC displaying the frame until it actually got painted.
+        lines << QStringLiteral("paint %1 ms  present delay %2 ms")
+                 .arg(frameStatistics.value(QStringLiteral("paintTime")).toLongLong() / 1000.0, 0, 'f', 1)
+                 .arg(frameStatistics.value(QStringLiteral("presentDelay")).toLongLong() / 1000.0, 0, 'f', 1);
+    }
+    m_lastFrameStatistics = frameStatistics;
+
+    m_text = lines.join(QLatin1Char('\n'));
+}
+
+void PerformanceOverlay::paint(QPainter *painter, const QRect &rect) const
+{
+    if (m_text.isEmpty())
+        return;
+
+    painter->save();
+    painter->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    const QRect textRect = painter->boundingRect(rect.adjusted(OVERLAY_MARGIN, OVERLAY_MARGIN, 0, 0),
+                                                 Qt::AlignLeft | Qt::AlignTop, m_text);
+    painter->fillRect(textRect.adjusted(-OVERLAY_MARGIN, -OVERLAY_MARGIN, OVERLAY_MARGIN, OVERLAY_MARGIN),
+                      QColor(0, 0, 0, 160));
+    painter->setPen(Qt::white);
+    painter->drawText(textRect, Qt::AlignLeft | Qt::AlignTop, m_text);
+    painter->restore();
+}
+
+} // namespace VLC
+} // namespace Phonon
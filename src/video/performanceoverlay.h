@@ -0,0 +1,74 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_VLC_PERFORMANCEOVERLAY_H
+#define PHONON_VLC_PERFORMANCEOVERLAY_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QString>
+#include <QtCore/QVariantMap>
+
+#include <vlc/vlc.h>
+
+class QPainter;
+class QRect;
+
+namespace Phonon {
+namespace VLC {
+
+class MediaPlayer;
+
+/** \brief Playback performance figures for display on top of the video
+ *
+ * Rates are computed from the difference between two samples, so sample()
+ * is meant to be called periodically, about once a second. The figures come
+ * from libVLC's media statistics and the surface painter's frame statistics
+ * (see VideoWidget::frameStatistics()). libVLC only collects statistics when
+ * PHONON_VLC_OVERLAY was set at startup, otherwise those lines are left out.
+ */
+class PerformanceOverlay
+{
+public:
+    PerformanceOverlay();
+
+    /**
+     * Takes a new sample and updates the text.
+     *
+     * \param player the player whose media to sample, may be null
+     * \param frameStatistics the surface painter's, empty if not in use
+     * \param bufferLevel input buffer fill level in percent
+     */
+    void sample(MediaPlayer *player, const QVariantMap &frameStatistics, int bufferLevel);
+
+    /// \returns the figures of the last sample, one per line
+    QString text() const { return m_text; }
+
+    /// Draws the text in the top left corner of \p rect.
+    void paint(QPainter *painter, const QRect &rect) const;
+
+private:
+    QElapsedTimer m_sampleTimer;
+    libvlc_media_stats_t m_lastStats;
+    bool m_hasLastStats;
+    QVariantMap m_lastFrameStatistics;
+    QString m_text;
+};
+
+} // namespace VLC
+} // namespace Phonon
+
+#endif // PHONON_VLC_PERFORMANCEOVERLAY_H
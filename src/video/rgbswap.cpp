@@ -0,0 +1,99 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "rgbswap.h"
+
+// Distributions build for the x86 baseline, which has no SSSE3. GCC and
+// Clang can compile single functions for it and tell at runtime whether the
+// CPU runs them.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PHONON_VLC_SWAP_SSSE3
+#include <tmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PHONON_VLC_SWAP_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Phonon {
+namespace VLC {
+
+#if defined(PHONON_VLC_SWAP_SSSE3)
+/// \returns the number of bytes done, whole pixels only
+__attribute__((target("ssse3")))
+static int swapRedBlueSsse3(uchar *data, int size)
+{
+    // Five pixels per 16 byte block, the last byte is stored unchanged and
+    // belongs to the next block. All four blocks are loaded before any store,
+    // loading right behind an overlapping store stalls the pipeline.
+    const __m128i mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+    int i = 0;
+    for (; i + 61 <= size; i += 60) {
+        __m128i *block = reinterpret_cast<__m128i *>(data + i);
+        const __m128i a = _mm_loadu_si128(block);
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<__m128i *>(data + i + 15));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<__m128i *>(data + i + 30));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<__m128i *>(data + i + 45));
+        // In order, each store fixes the byte the one before left unchanged.
+        _mm_storeu_si128(block, _mm_shuffle_epi8(a, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i + 15), _mm_shuffle_epi8(b, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i + 30), _mm_shuffle_epi8(c, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i + 45), _mm_shuffle_epi8(d, mask));
+    }
+    return i;
+}
+
+static bool hasSsse3()
+{
+    static const bool has = __builtin_cpu_supports("ssse3");
+    return has;
+}
+#endif
+
+/// Swaps the pixels from byte \p i on.
+static void swapTail(uchar *data, int i, int size)
+{
+    for (; i < size; i += 3) {
+        qSwap(data[i], data[i + 2]);
+    }
+}
+
+void swapRedBlue(uchar *data, int count)
+{
+    const int size = count * 3;
+    int i = 0;
+#if defined(PHONON_VLC_SWAP_SSSE3)
+    if (hasSsse3())
+        i = swapRedBlueSsse3(data, size);
+#elif defined(PHONON_VLC_SWAP_NEON)
+    for (; i + 48 <= size; i += 48) {
+        uint8x16x3_t pixels = vld3q_u8(data + i);
+        const uint8x16_t red = pixels.val[0];
+        pixels.val[0] = pixels.val[2];
+        pixels.val[2] = red;
+        vst3q_u8(data + i, pixels);
+    }
+#endif
+    swapTail(data, i, size);
+}
+
+void swapRedBlueScalar(uchar *data, int count)
+{
+    swapTail(data, 0, count * 3);
+}
+
+} // namespace VLC
+} // namespace Phonon
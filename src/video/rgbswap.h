@@ -0,0 +1,41 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_VLC_RGBSWAP_H
+#define PHONON_VLC_RGBSWAP_H
+
+#include <QtCore/QtGlobal>
+
+namespace Phonon {
+namespace VLC {
+
+/**
+ * Swaps the first and third byte of \p count packed 24 bit pixels, turning
+ * RGB888 into BGR888 and back.
+ *
+ * Uses SSSE3 when the CPU has it, checked at runtime so that builds for the
+ * x86 baseline get it too, and NEON where the compiler targets it.
+ */
+void swapRedBlue(uchar *data, int count);
+
+/// swapRedBlue() in plain C++, to compare against.
+void swapRedBlueScalar(uchar *data, int count);
+
+} // namespace VLC
+} // namespace Phonon
+
+#endif // PHONON_VLC_RGBSWAP_H
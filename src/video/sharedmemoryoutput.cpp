@@ -0,0 +1,335 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sharedmemoryoutput.h"
+
+#include <atomic>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "utils/debug.h"
+#include "mediaobject.h"
+#include "mediaplayer.h"
+#include "video/latencystatistics.h"
+#include "video/videoframefanout.h"
+
+// Frames in the ring, a reader has about this many frame times to read one.
+#define SHARED_FRAME_SLOTS 4
+// Room reserved for the slot header, the planes start after it.
+#define SLOT_HEADER_SIZE 128
+// Planes start on cache lines.
+#define PLANE_ALIGNMENT 64
+
+namespace Phonon {
+namespace VLC {
+
+Q_STATIC_ASSERT(sizeof(SharedFrameSlotHeader) <= SLOT_HEADER_SIZE);
+
+/// \returns the page size, the ring header takes the first page
+static quint32 pageSize()
+{
+    static const quint32 size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+static quint32 alignedTo(quint32 value, quint32 alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/// \returns the sequence number following \p sequence, 0 means unwritten
+static quint32 nextSequence(quint32 sequence)
+{
+    return sequence == 0xffffffff ? 1 : sequence + 1;
+}
+
+SharedMemoryOutput::SharedMemoryOutput(QObject *parent)
+    : QObject(parent)
+    , SinkNode()
+    , m_attachedPlayer(0)
+    , m_memoryFd(-1)
+    , m_eventFd(-1)
+    , m_memory(0)
+    , m_memorySize(0)
+    , m_slotSize(0)
+    , m_writeSlot(-1)
+    , m_sequence(0)
+    , m_captureTime(0)
+{
+    m_format.chroma = 0;
+    m_format.width = 0;
+    m_format.height = 0;
+    m_format.planeCount = 0;
+    for (int plane = 0; plane < 3; ++plane) {
+        m_format.pitches[plane] = 0;
+        m_format.lines[plane] = 0;
+        m_format.offsets[plane] = 0;
+    }
+
+    m_memoryFd = memfd_create("phonon-vlc-frames", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (m_memoryFd < 0) {
+        error() << "could not create the frame memory:" << strerror(errno);
+        return;
+    }
+    // Readers may rely on their mappings staying valid.
+    if (fcntl(m_memoryFd, F_ADD_SEALS, F_SEAL_SHRINK) != 0)
+        warning() << "could not seal the frame memory:" << strerror(errno);
+
+    m_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_eventFd < 0)
+        warning() << "could not create the frame eventfd:" << strerror(errno);
+
+    // The ring header is there right away, so readers can map it early.
+    if (!reserve(pageSize()))
+        return;
+    SharedFrameRingHeader *header = ringHeader();
+    header->magic = SHARED_FRAME_MAGIC;
+    header->version = SHARED_FRAME_VERSION;
+    header->slotCount = 0;
+    header->slotSize = 0;
+    header->slotOffset = 0;
+    header->size = m_memorySize;
+    header->sequence.storeRelaxed(0);
+    header->generation.storeRelease(0);
+}
+
+SharedMemoryOutput::~SharedMemoryOutput()
+{
+    if (m_memory)
+        munmap(m_memory, m_memorySize);
+    if (m_memoryFd >= 0)
+        close(m_memoryFd);
+    if (m_eventFd >= 0)
+        close(m_eventFd);
+}
+
+int SharedMemoryOutput::memoryFileDescriptor() const
+{
+    return m_memory ? m_memoryFd : -1;
+}
+
+int SharedMemoryOutput::eventFileDescriptor() const
+{
+    return m_eventFd;
+}
+
+void SharedMemoryOutput::handleConnectToMediaObject(MediaObject *mediaObject)
+{
+    Q_UNUSED(mediaObject);
+}
+
+void SharedMemoryOutput::handleDisconnectFromMediaObject(MediaObject *mediaObject)
+{
+    Q_UNUSED(mediaObject);
+    // The callbacks may have been taken over by now.
+    if (m_attachedPlayer && m_attachedPlayer == m_player && !isFanoutActive())
+        unsetCallbacks(m_player);
+    m_attachedPlayer = 0;
+}
+
+void SharedMemoryOutput::handleAddToMedia(Media *media)
+{
+    if (m_mediaObject && m_mediaObject->isAudioOnly())
+        return;
+
+    media->addOption(":video");
+
+    // Taking the callbacks from the fan-out would leave all its sinks blank.
+    if (isFanoutActive()) {
+        warning() << "not exporting frames, other video sinks already decode to memory";
+        m_attachedPlayer = 0;
+        return;
+    }
+    setCallbacks(m_player);
+    m_attachedPlayer = m_player;
+}
+
+bool SharedMemoryOutput::isFanoutActive() const
+{
+    VideoFrameFanout *fanout = m_player
+            ? m_player->findChild<VideoFrameFanout *>(QString(), Qt::FindDirectChildrenOnly) : 0;
+    return fanout && fanout->hasReceivers();
+}
+
+void *SharedMemoryOutput::lockCallback(void **planes)
+{
+    // Like the frame fan-out, VLC decodes into the write slot until it got
+    // displayed.
+    if (m_writeSlot < 0 && m_memory && m_slotSize > 0) {
+        m_writeSlot = nextSequence(m_sequence) % SHARED_FRAME_SLOTS;
+        // Readers of the frame previously in the slot see it is gone before
+        // it gets overwritten.
+        slotHeader(m_writeSlot)->sequence.storeRelaxed(0);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    uchar *slot = m_writeSlot >= 0 ? reinterpret_cast<uchar *>(slotHeader(m_writeSlot)) : 0;
+    for (quint32 plane = 0; plane < 3; ++plane) {
+        planes[plane] = slot && plane < m_format.planeCount ? slot + m_format.offsets[plane] : 0;
+    }
+    return 0;
+}
+
+void SharedMemoryOutput::unlockCallback(void *picture, void *const *planes)
+{
+    Q_UNUSED(picture);
+    Q_UNUSED(planes);
+    m_captureTime = LatencyStatistics::now();
+}
+
+void SharedMemoryOutput::displayCallback(void *picture)
+{
+    Q_UNUSED(picture);
+    if (m_writeSlot < 0)
+        return;
+
+    SharedFrameSlotHeader *header = slotHeader(m_writeSlot);
+    header->chroma = m_format.chroma;
+    header->width = m_format.width;
+    header->height = m_format.height;
+    header->planeCount = m_format.planeCount;
+    for (int plane = 0; plane < 3; ++plane) {
+        header->pitches[plane] = m_format.pitches[plane];
+        header->lines[plane] = m_format.lines[plane];
+        header->offsets[plane] = m_format.offsets[plane];
+    }
+    // VLC displays frames on the playback clock.
+    header->presentationTime = m_player ? m_player->lastTime() : -1;
+    header->captureTime = m_captureTime;
+
+    m_sequence = nextSequence(m_sequence);
+    header->sequence.storeRelease(m_sequence);
+    ringHeader()->sequence.storeRelease(m_sequence);
+    m_writeSlot = -1;
+
+    if (m_eventFd >= 0) {
+        // Only fails once the counter is about to overflow, readers reset it.
+        const quint64 frames = 1;
+        if (write(m_eventFd, &frames, sizeof(frames)) < 0 && errno != EAGAIN)
+            warning() << "could not signal the frame:" << strerror(errno);
+    }
+}
+
+unsigned SharedMemoryOutput::formatCallback(char *chroma,
+                                            unsigned *width, unsigned *height,
+                                            unsigned *pitches,
+                                            unsigned *lines)
+{
+    DEBUG_BLOCK;
+    m_writeSlot = -1;
+    if (!m_memory)
+        return 0;
+
+    // Whatever the decoder yields is passed on as is, saving VLC any
+    // conversion, unless the slot header cannot describe it.
+    vlc_fourcc_t fourcc = VLC_FOURCC(chroma[0], chroma[1], chroma[2], chroma[3]);
+    unsigned bufferSize = setPitchAndLines(fourcc, *width, *height, pitches, lines);
+    if (bufferSize == 0 || pitches[3] != 0) {
+        memcpy(chroma, "I420", 4);
+        fourcc = VLC_CODEC_I420;
+        bufferSize = setPitchAndLines(fourcc, *width, *height, pitches, lines);
+    }
+
+    m_format.chroma = fourcc;
+    m_format.width = *width;
+    m_format.height = *height;
+    m_format.planeCount = 0;
+    quint32 offset = SLOT_HEADER_SIZE;
+    for (int plane = 0; plane < 3; ++plane) {
+        m_format.pitches[plane] = pitches[plane];
+        m_format.lines[plane] = lines[plane];
+        m_format.offsets[plane] = pitches[plane] ? offset : 0;
+        if (pitches[plane]) {
+            ++m_format.planeCount;
+            offset = alignedTo(offset + pitches[plane] * lines[plane], PLANE_ALIGNMENT);
+        }
+    }
+
+    m_slotSize = alignedTo(offset, pageSize());
+    if (!reserve(pageSize() + SHARED_FRAME_SLOTS * m_slotSize)) {
+        m_slotSize = 0;
+        return 0;
+    }
+
+    // Seqlock write: readers retry while the generation is odd or changed.
+    SharedFrameRingHeader *header = ringHeader();
+    const quint32 generation = header->generation.loadRelaxed();
+    header->generation.storeRelaxed(generation + 1);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Invalidate the frames of the old format before the layout changes.
+    for (int slot = 0; slot < SHARED_FRAME_SLOTS; ++slot) {
+        slotHeader(slot)->sequence.storeRelaxed(0);
+    }
+    header->slotCount = SHARED_FRAME_SLOTS;
+    header->slotSize = m_slotSize;
+    header->slotOffset = pageSize();
+    header->size = m_memorySize;
+    header->generation.storeRelease(generation + 2);
+
+    return bufferSize;
+}
+
+void SharedMemoryOutput::formatCleanUpCallback()
+{
+    DEBUG_BLOCK;
+    m_writeSlot = -1;
+}
+
+bool SharedMemoryOutput::reserve(quint32 size)
+{
+    if (size <= m_memorySize)
+        return true;
+
+    // Growing only, readers keep their mappings and remap when they need more.
+    if (ftruncate(m_memoryFd, size) != 0) {
+        error() << "could not grow the frame memory to" << size << "bytes:" << strerror(errno);
+        return false;
+    }
+    void *memory = m_memory
+            ? mremap(m_memory, m_memorySize, size, MREMAP_MAYMOVE)
+            : mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_memoryFd, 0);
+    if (memory == MAP_FAILED) {
+        error() << "could not map the frame memory:" << strerror(errno);
+        if (m_memory)
+            munmap(m_memory, m_memorySize);
+        m_memory = 0;
+        m_memorySize = 0;
+        return false;
+    }
+    m_memory = static_cast<uchar *>(memory);
+    m_memorySize = size;
+    return true;
+}
+
+SharedFrameRingHeader *SharedMemoryOutput::ringHeader() const
+{
+    return reinterpret_cast<SharedFrameRingHeader *>(m_memory);
+}
+
+SharedFrameSlotHeader *SharedMemoryOutput::slotHeader(int slot) const
+{
+    return reinterpret_cast<SharedFrameSlotHeader *>(m_memory + pageSize() + slot * m_slotSize);
+}
+
+} // namespace VLC
+} // namespace Phonon
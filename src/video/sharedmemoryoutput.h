@@ -0,0 +1,169 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_VLC_SHAREDMEMORYOUTPUT_H
+#define PHONON_VLC_SHAREDMEMORYOUTPUT_H
+
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QObject>
+
+#include "sinknode.h"
+#include "videomemorystream.h"
+
+namespace Phonon {
+namespace VLC {
+
+/// SharedFrameRingHeader::magic, "PVFR" in memory.
+#define SHARED_FRAME_MAGIC 0x52465650
+/// SharedFrameRingHeader::version, bumped on incompatible layout changes.
+#define SHARED_FRAME_VERSION 1
+
+/**
+ * Start of the shared memory, its first page. Integers are native endian,
+ * the atomics are plain 32 bit integers to be accessed with acquire loads.
+ */
+struct SharedFrameRingHeader
+{
+    quint32 magic;
+    quint32 version;
+    /// Odd while the fields below change, on format changes, see
+    /// SharedMemoryOutput for the reader side.
+    QAtomicInteger<quint32> generation;
+    quint32 slotCount;
+    /// Bytes per slot, page aligned.
+    quint32 slotSize;
+    /// Offset of the first slot, slot n is at slotOffset + n * slotSize.
+    quint32 slotOffset;
+    /// Size of the memory, it only ever grows.
+    quint32 size;
+    /// Sequence number of the latest frame, 0 before the first.
+    QAtomicInteger<quint32> sequence;
+};
+
+/**
+ * Start of every slot. A slot holds the frame with sequence number n in
+ * slot n % slotCount.
+ */
+struct SharedFrameSlotHeader
+{
+    /// Sequence number of the frame in the slot, 0 while it is being written.
+    QAtomicInteger<quint32> sequence;
+    /// VLC fourcc of the chroma, e.g. "I420" in memory.
+    quint32 chroma;
+    quint32 width;
+    quint32 height;
+    quint32 planeCount;
+    quint32 pitches[3];
+    quint32 lines[3];
+    /// Plane offsets from the start of the slot.
+    quint32 offsets[3];
+    /// Media time at display in msecs, see MediaPlayer::lastTime(); -1 if unknown.
+    qint64 presentationTime;
+    /// When decoding finished, CLOCK_MONOTONIC in nanoseconds.
+    qint64 captureTime;
+};
+
+/** \brief Exports decoded frames to other local processes through shared memory
+ *
+ * Created through Backend::createSharedMemoryOutput() and connected to a
+ * MediaObject like any other sink. VLC decodes straight into a ring of frame
+ * slots in a memfd, in the decoder's own chroma where it has at most three
+ * planes (I420 otherwise), so frames reach the reader without any copy.
+ * The memory and the eventfd signalled for every frame are handed to the
+ * reading process as file descriptors, e.g. over a Unix socket.
+ *
+ * The writer never waits for readers. Per frame, a reader
+ * \li reads SharedFrameRingHeader::sequence n, the slot is n % slotCount
+ * \li checks the slot's sequence is n, otherwise the frame was overwritten
+ * \li reads the frame, then checks the slot's sequence is still n (after an
+ *     acquire fence); if not, the frame got overwritten while reading
+ *
+ * The ring header's fields are guarded by SharedFrameRingHeader::generation
+ * like a seqlock: it is odd while the writer changes them, on format changes.
+ * A reader
+ * \li reads the generation g (acquire), waits and retries while it is odd
+ * \li reads the fields, remapping if size grew past its mapping
+ * \li checks the generation is still g (after an acquire fence), otherwise
+ *     retries
+ *
+ * and does so again whenever the generation differs from the g it has. The
+ * memory is sealed against shrinking, so mappings stay valid.
+ *
+ * The output sets the player's memory callbacks, of which there is only one
+ * set. It does not attach while the player's VideoFrameFanout serves other
+ * video sinks (VideoWidget's surface painting, VideoItem, ...), and such
+ * sinks added later take the callbacks over. VideoDataOutput cannot be
+ * combined with it either.
+ */
+class SharedMemoryOutput : public QObject, public SinkNode, private VideoMemoryStream
+{
+    Q_OBJECT
+public:
+    explicit SharedMemoryOutput(QObject *parent = nullptr);
+    ~SharedMemoryOutput();
+
+    /// \returns the memfd holding the frames, -1 if it could not be created
+    Q_INVOKABLE int memoryFileDescriptor() const;
+
+    /// \returns the eventfd incremented for every frame, -1 if none
+    Q_INVOKABLE int eventFileDescriptor() const;
+
+    void handleConnectToMediaObject(MediaObject *mediaObject) override;
+    void handleDisconnectFromMediaObject(MediaObject *mediaObject) override;
+    void handleAddToMedia(Media *media) override;
+    bool isVideoSink() const override { return true; }
+
+private:
+    void *lockCallback(void **planes) override;
+    void unlockCallback(void *picture, void *const *planes) override;
+    void displayCallback(void *picture) override;
+    unsigned formatCallback(char *chroma,
+                            unsigned *width, unsigned *height,
+                            unsigned *pitches,
+                            unsigned *lines) override;
+    void formatCleanUpCallback() override;
+
+    /// Grows the memory to \p size and maps it, \returns false on failure
+    bool reserve(quint32 size);
+
+    SharedFrameRingHeader *ringHeader() const;
+    SharedFrameSlotHeader *slotHeader(int slot) const;
+
+    /// \returns whether the player's frame fan-out serves other sinks
+    bool isFanoutActive() const;
+
+    /// Player whose callbacks are set to this, 0 if none.
+    MediaPlayer *m_attachedPlayer;
+    int m_memoryFd;
+    int m_eventFd;
+    uchar *m_memory;
+    quint32 m_memorySize;
+
+    // Only touched by VLC's vout thread.
+    /// Frame geometry, copied into every slot header on display.
+    SharedFrameSlotHeader m_format;
+    quint32 m_slotSize;
+    /// Slot VLC decodes into until it got displayed, -1 if none.
+    int m_writeSlot;
+    quint32 m_sequence;
+    qint64 m_captureTime;
+};
+
+} // namespace VLC
+} // namespace Phonon
+
+#endif // PHONON_VLC_SHAREDMEMORYOUTPUT_H
@@ -26,26 +26,211 @@
 #include <phonon/experimental/abstractvideodataoutput.h>
 
 #include <QMetaObject>
+#include <QThread>
 
 #include "utils/debug.h"
 #include "media.h"
 #include "mediaobject.h"
+#include "mediaplayer.h"
+#include "rgbswap.h"
 
 using namespace Phonon::Experimental;
 
+// Frames waiting for delivery by default, see setQueueLimit().
+#define DEFAULT_QUEUE_LIMIT 3
+
 namespace Phonon
 {
 namespace VLC
 {
 
+/// How a VLC chroma is handed out as VideoFrame2.
+struct FormatMapping {
+    char chroma[5];
+    VideoFrame2::Format format;
+    /// The chroma planes come in U, V order, VideoFrame2's YV12 is V, U.
+    bool swapChroma;
+};
+
+/**
+ * Chromas VideoFrame2 can carry without conversion. When VLC's decoder
+ * output is not among them (or not allowed by the frontend) the first
+ * allowed one is asked for, so they are in order of preference. Decoders
+ * nearly always yield YUV, converting between YUV layouts is cheap while RGB
+ * costs VLC a colour conversion and 1.5 to 2 times the memory, so YUV comes
+ * first. VLC's RV24 is BGR in memory and needs swapping, so it is only used
+ * when nothing else is. VideoFrame2 has no semi-planar format, NV12 gets
+ * converted.
+ */
+static const FormatMapping s_formats[] = {
+    { "YV12", VideoFrame2::Format_YV12, false },
+    { "I420", VideoFrame2::Format_YV12, true },
+    { "YUY2", VideoFrame2::Format_YUY2, false },
+    { "RV32", VideoFrame2::Format_RGB32, false },
+    { "RV24", VideoFrame2::Format_RGB888, false }
+};
+
+/// \returns the mapping of \p chroma, null if VideoFrame2 cannot carry it
+static const FormatMapping *formatForChroma(const char *chroma)
+{
+    for (const FormatMapping &mapping : s_formats) {
+        if (qstrncmp(chroma, mapping.chroma, 4) == 0)
+            return &mapping;
+    }
+    return 0;
+}
+
+/// \returns whether no consumer holds a copy of \p plane anymore
+static bool isReleased(const QByteArray &plane)
+{
+    return plane.isEmpty() || plane.isDetached();
+}
+
+/// \returns whether neither the queue nor a consumer holds \p frame
+static bool isReleased(const VideoFrame2 &frame)
+{
+    return isReleased(frame.data0) && isReleased(frame.data1) && isReleased(frame.data2);
+}
+
+/// Copies \p rows rows of \p rowBytes from \p source at \p x, \p y bytes into \p target.
+static void copyPlane(const QByteArray &source, int pitch, int x, int y,
+                      int rowBytes, int rows, QByteArray *target)
+{
+    const char *in = source.constData() + y * pitch + x;
+    char *out = target->data();
+    for (int row = 0; row < rows; ++row) {
+        memcpy(out + row * rowBytes, in + row * pitch, rowBytes);
+    }
+}
+
+/// \returns the bytes per pixel of the first plane of \p format
+static int bytesPerPixel(VideoFrame2::Format format)
+{
+    switch (format) {
+    case VideoFrame2::Format_RGB32:
+        return 4;
+    case VideoFrame2::Format_RGB888:
+        return 3;
+    case VideoFrame2::Format_YUY2:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
 VideoDataOutput::VideoDataOutput(QObject *parent)
     : QObject(parent)
     , m_frontend(0)
+    , m_swapChroma(false)
+    , m_writeFrame(-1)
+    , m_captureTime(0)
+    , m_skipFrame(false)
+    , m_nextCaptureTime(0)
+    , m_queueLimit(DEFAULT_QUEUE_LIMIT)
+    , m_dropPolicy(DropOldest)
+    , m_targetFrameRate(0)
+    , m_stopDelivery(false)
+    , m_delivering(false)
+    , m_delivered(0)
+    , m_dropped(0)
 {
+    m_format.format = VideoFrame2::Format_Invalid;
+    for (int plane = 0; plane < 3; ++plane) {
+        m_planeSizes[plane] = 0;
+        m_planePitches[plane] = 0;
+    }
+
+    m_deliveryThread = QThread::create([this] { deliverFrames(); });
+    m_deliveryThread->setObjectName(QStringLiteral("VideoDataOutput delivery"));
+    m_deliveryThread->start();
 }
 
 VideoDataOutput::~VideoDataOutput()
 {
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stopDelivery = true;
+        m_queueCondition.wakeAll();
+    }
+    m_deliveryThread->wait();
+    delete m_deliveryThread;
+}
+
+void VideoDataOutput::setQueueLimit(int limit)
+{
+    QMutexLocker lock(&m_mutex);
+    m_queueLimit = qMax(1, limit);
+    while (m_queue.size() > m_queueLimit) {
+        if (m_dropPolicy == DropOldest)
+            m_queue.dequeue();
+        else
+            m_queue.removeLast();
+        ++m_dropped;
+    }
+}
+
+int VideoDataOutput::queueLimit() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_queueLimit;
+}
+
+void VideoDataOutput::setDropPolicy(DropPolicy policy)
+{
+    QMutexLocker lock(&m_mutex);
+    m_dropPolicy = policy;
+}
+
+VideoDataOutput::DropPolicy VideoDataOutput::dropPolicy() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_dropPolicy;
+}
+
+void VideoDataOutput::setTargetFrameRate(qreal fps)
+{
+    QMutexLocker lock(&m_mutex);
+    m_targetFrameRate = qMax<qreal>(0, fps);
+}
+
+qreal VideoDataOutput::targetFrameRate() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_targetFrameRate;
+}
+
+void VideoDataOutput::setCropRect(const QRect &rect)
+{
+    QMutexLocker lock(&m_mutex);
+    m_cropRect = rect;
+}
+
+QRect VideoDataOutput::cropRect() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_cropRect;
+}
+
+void VideoDataOutput::setMaximumSize(const QSize &size)
+{
+    QMutexLocker lock(&m_mutex);
+    m_maximumSize = size;
+}
+
+QSize VideoDataOutput::maximumSize() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_maximumSize;
+}
+
+QVariantMap VideoDataOutput::frameStatistics() const
+{
+    QMutexLocker lock(&m_mutex);
+    QVariantMap statistics;
+    statistics.insert(QStringLiteral("delivered"), m_delivered);
+    statistics.insert(QStringLiteral("dropped"), m_dropped);
+    m_deliveryLatency.insertInto(&statistics, QStringLiteral("deliveryLatency"));
+    return statistics;
 }
 
 void VideoDataOutput::handleConnectToMediaObject(MediaObject *mediaObject)
@@ -58,30 +243,52 @@ void VideoDataOutput::handleDisconnectFromMediaObject(MediaObject *mediaObject)
 {
     Q_UNUSED(mediaObject);
     unsetCallbacks(m_player);
+
+    // Frames of the old player are of no interest anymore.
+    QMutexLocker lock(&m_mutex);
+    m_queue.clear();
 }
 
 void VideoDataOutput::handleAddToMedia(Media *media)
 {
+    if (m_mediaObject && m_mediaObject->isAudioOnly())
+        return;
+
     media->addOption(":video");
 }
 
 Experimental::AbstractVideoDataOutput *VideoDataOutput::frontendObject() const
 {
+    QMutexLocker lock(&m_mutex);
     return m_frontend;
 }
 
 void VideoDataOutput::setFrontendObject(Experimental::AbstractVideoDataOutput *frontend)
 {
+    QMutexLocker lock(&m_mutex);
     m_frontend = frontend;
+    // The old frontend may be deleted once we return, so wait until it got
+    // its last frame. From within frameReady() there is nothing to wait for.
+    if (QThread::currentThread() == m_deliveryThread)
+        return;
+    while (m_delivering)
+        m_deliveryCondition.wait(&m_mutex);
 }
 
 void *VideoDataOutput::lockCallback(void **planes)
 {
-    m_mutex.lock();
-    DEBUG_BLOCK;
-    planes[0] = reinterpret_cast<void *>(m_frame.data0.data());
-    planes[1] = reinterpret_cast<void *>(m_frame.data1.data());
-    planes[2] = reinterpret_cast<void *>(m_frame.data2.data());
+    // Like the frame fan-out, VLC decodes into the write frame until it got
+    // displayed.
+    if (m_writeFrame < 0)
+        m_writeFrame = takeFreeFrame();
+    VideoFrame2 &frame = m_pool[m_writeFrame];
+    planes[0] = frame.data0.isEmpty() ? 0 : reinterpret_cast<void *>(frame.data0.data());
+    planes[1] = frame.data1.isEmpty() ? 0 : reinterpret_cast<void *>(frame.data1.data());
+    planes[2] = frame.data2.isEmpty() ? 0 : reinterpret_cast<void *>(frame.data2.data());
+    if (m_swapChroma) {
+        // I420 decodes U first, into the plane YV12 has V in.
+        qSwap(planes[1], planes[2]);
+    }
     return 0;
 }
 
@@ -89,68 +296,74 @@ void VideoDataOutput::unlockCallback(void *picture, void *const*planes)
 {
     Q_UNUSED(picture);
     Q_UNUSED(planes);
-    DEBUG_BLOCK;
+    if (m_writeFrame < 0)
+        return;
+    m_captureTime = LatencyStatistics::now();
+
+    qreal targetFrameRate;
+    QRect cropRect;
+    {
+        QMutexLocker lock(&m_mutex);
+        targetFrameRate = m_targetFrameRate;
+        cropRect = m_cropRect;
+    }
 
-    // For some reason VLC yields BGR24, so we swap it to RGB
-    if (m_frame.format == Experimental::VideoFrame2::Format_RGB888) {
-        uchar *data = (uchar *) m_frame.data0.data();
-        uchar tmp;
-        for (int i = 0; i < m_frame.data0.size(); i += 3) {
-            tmp = data[i];
-            data[i] = data[i+2];
-            data[i+2] = tmp;
+    // Decimate on the decoding clock. Skipped frames are not displayed by
+    // us, VLC decodes the next one into the same buffer.
+    m_skipFrame = false;
+    if (targetFrameRate > 0) {
+        const qint64 interval = qint64(1000000000 / targetFrameRate);
+        if (m_captureTime < m_nextCaptureTime) {
+            m_skipFrame = true;
+            return;
         }
+        // Keep the average rate, but do not catch up on a stall.
+        m_nextCaptureTime = qMax(m_nextCaptureTime, m_captureTime - interval) + interval;
     }
 
-    if (m_frontend)
-        m_frontend->frameReady(m_frame);
+    m_cropRegion = cropRegion(cropRect);
+    if (m_cropRegion != QRect(0, 0, m_format.width, m_format.height)) {
+        // Swapped after cropping, on the fraction of the frame delivered.
+        return;
+    }
 
-    m_mutex.unlock();
+    // VLC's RV24 is BGR in memory, swap it to RGB. Rows are padded, so go
+    // row by row to stay within the plane.
+    VideoFrame2 &frame = m_pool[m_writeFrame];
+    if (frame.format == Experimental::VideoFrame2::Format_RGB888) {
+        uchar *data = reinterpret_cast<uchar *>(frame.data0.data());
+        for (int row = 0; row < frame.height; ++row) {
+            swapRedBlue(data + row * m_planePitches[0], frame.width);
+        }
+    }
 }
 
 void VideoDataOutput::displayCallback(void *picture)
 {
     Q_UNUSED(picture);
-    DEBUG_BLOCK;
-    // We send the frame while unlocking as we could loose syncing otherwise.
-    // With VDO the consumer is expected to ensure syncness while not blocking
-    // unlock for long periods of time. Good luck with that... -.-
-}
+    if (m_writeFrame < 0 || m_skipFrame)
+        return;
 
-static VideoFrame2::Format fourccToFormat(const char *fourcc)
-{
-    if (qstrcmp(fourcc, "RV24"))
-        return VideoFrame2::Format_RGB888;
-    else if (qstrcmp(fourcc, "RV32"))
-        return VideoFrame2::Format_RGB32;
-    else if (qstrcmp(fourcc, "YV12"))
-        return VideoFrame2::Format_YV12;
-    else if (qstrcmp(fourcc, "YUY2"))
-        return VideoFrame2::Format_YUY2;
-    else
-        return VideoFrame2::Format_Invalid;
-}
+    if (m_cropRegion.isEmpty()) {
+        // Cropped to nothing.
+        return;
+    }
 
-static uint32_t setFormat(VideoFrame2::Format format, char **chroma)
-{
-    switch (format) {
-    case VideoFrame2::Format_Invalid:
-        *chroma = nullptr;
-        return 0;
-    case VideoFrame2::Format_RGB32:
-        qstrcpy(*chroma, "RV32");
-        return VLC_CODEC_RGB32;
-    case VideoFrame2::Format_RGB888:
-        qstrcpy(*chroma, "RV24");
-        return VLC_CODEC_RGB24;
-    case VideoFrame2::Format_YV12:
-        qstrcpy(*chroma, "YV12");
-        return VLC_CODEC_YV12;
-    case VideoFrame2::Format_YUY2:
-        qstrcpy(*chroma, "YUY2");
-        return VLC_CODEC_YUYV;
+    // Delivered off the decoder thread, so the consumer can take its time
+    // without VLC losing sync. The queued copy keeps the buffers from being
+    // decoded into until the consumer is done with them. Cropped frames are
+    // copies, VLC may decode into the write frame again right away.
+    QueuedFrame queued;
+    if (m_cropRegion == QRect(0, 0, m_format.width, m_format.height)) {
+        queued.frame = m_pool.at(m_writeFrame);
+        m_writeFrame = -1;
+    } else {
+        queued.frame = cropFrame(m_pool.at(m_writeFrame), m_cropRegion);
     }
-    return 0;
+    // VLC displays frames on the playback clock.
+    queued.presentationTime = m_player ? m_player->lastTime() : -1;
+    queued.captureTime = m_captureTime;
+    queueFrame(queued);
 }
 
 unsigned VideoDataOutput::formatCallback(char *chroma,
@@ -159,34 +372,76 @@ unsigned VideoDataOutput::formatCallback(char *chroma,
 {
     DEBUG_BLOCK;
 
-    m_frame.width = *width;
-    m_frame.height = *height;
-
-    uint32_t fourcc = 0;
-
-    QSet<VideoFrame2::Format> allowedFormats = m_frontend->allowedFormats();
-    VideoFrame2::Format suggestedFormat = fourccToFormat(chroma);
-    if (suggestedFormat != VideoFrame2::Format_Invalid
-            && allowedFormats.contains(suggestedFormat)) { // Use suggested
-        fourcc = setFormat(suggestedFormat, &chroma);
-        m_frame.format = suggestedFormat;
-    } else { // Pick first and use that
-        foreach (const VideoFrame2::Format &format, allowedFormats) {
-            fourcc = setFormat(format, &chroma);
-            if (fourcc > 0) {
-                m_frame.format = format;
+    // Frames of the old format stay valid for the consumers holding them.
+    m_pool.clear();
+    m_cropPool.clear();
+    m_writeFrame = -1;
+    m_nextCaptureTime = 0;
+
+    QSize maximumSize;
+    QRect cropRect;
+    {
+        QMutexLocker lock(&m_mutex);
+        maximumSize = m_maximumSize;
+        cropRect = m_cropRect;
+    }
+
+    // Have VLC scale down so the delivered part fits the maximum size, the
+    // scaler runs as part of its chroma conversion anyway.
+    m_sourceSize = QSize(*width, *height);
+    const QSize deliveredSize = cropRect.isNull()
+            ? m_sourceSize : cropRect.intersected(QRect(QPoint(0, 0), m_sourceSize)).size();
+    if (maximumSize.isValid() && !deliveredSize.isEmpty()
+            && (deliveredSize.width() > maximumSize.width()
+                || deliveredSize.height() > maximumSize.height())) {
+        const qreal scale = qMin(qreal(maximumSize.width()) / deliveredSize.width(),
+                                 qreal(maximumSize.height()) / deliveredSize.height());
+        *width = qMax(1, qRound(*width * scale));
+        *height = qMax(1, qRound(*height * scale));
+        debug() << "scaling" << m_sourceSize << "frames down to" << QSize(*width, *height);
+    }
+    m_format.width = *width;
+    m_format.height = *height;
+
+    Experimental::AbstractVideoDataOutput *frontend = frontendObject();
+    if (!frontend) {
+        warning() << "no frontend, no format";
+        return 0;
+    }
+    const QSet<VideoFrame2::Format> allowedFormats = frontend->allowedFormats();
+
+    // Take the decoder output as is whenever possible, any other chroma
+    // costs a conversion in VLC. RV24 would cost a swap on our end as well.
+    const FormatMapping *mapping = formatForChroma(chroma);
+    if (!mapping || mapping->format == VideoFrame2::Format_RGB888
+            || !allowedFormats.contains(mapping->format)) {
+        mapping = 0;
+        for (const FormatMapping &candidate : s_formats) {
+            if (allowedFormats.contains(candidate.format)) {
+                mapping = &candidate;
                 break;
             }
         }
     }
+    if (!mapping) {
+        warning() << "frontend allows none of the supported formats";
+        return 0;
+    }
 
-    Q_ASSERT(fourcc > 0);
+    debug() << "decoder chroma" << QByteArray(chroma, 4) << "delivering" << mapping->chroma;
+    memcpy(chroma, mapping->chroma, 4);
+    m_format.format = mapping->format;
+    m_swapChroma = mapping->swapChroma;
+    const vlc_fourcc_t fourcc = VLC_FOURCC(chroma[0], chroma[1], chroma[2], chroma[3]);
 
     unsigned int bufferSize = setPitchAndLines(fourcc, *width, *height, pitches, lines);
 
-    m_frame.data0.resize(pitches[0] * lines[0]);
-    m_frame.data1.resize(pitches[1] * lines[1]);
-    m_frame.data2.resize(pitches[2] * lines[0]);
+    // In the order of the VideoFrame2 planes.
+    for (int plane = 0; plane < 3; ++plane) {
+        const int vlcPlane = m_swapChroma && plane > 0 ? 3 - plane : plane;
+        m_planeSizes[plane] = pitches[vlcPlane] * lines[vlcPlane];
+        m_planePitches[plane] = pitches[vlcPlane];
+    }
 
     return bufferSize;
 }
@@ -194,6 +449,133 @@ unsigned VideoDataOutput::formatCallback(char *chroma,
 void VideoDataOutput::formatCleanUpCallback()
 {
     DEBUG_BLOCK;
+    m_pool.clear();
+    m_cropPool.clear();
+    m_writeFrame = -1;
+}
+
+int VideoDataOutput::takeFreeFrame()
+{
+    for (int i = 0; i < m_pool.size(); ++i) {
+        if (isReleased(m_pool.at(i)))
+            return i;
+    }
+
+    VideoFrame2 frame = m_format;
+    frame.data0 = QByteArray(m_planeSizes[0], Qt::Uninitialized);
+    frame.data1 = QByteArray(m_planeSizes[1], Qt::Uninitialized);
+    frame.data2 = QByteArray(m_planeSizes[2], Qt::Uninitialized);
+    m_pool << frame;
+    return m_pool.size() - 1;
+}
+
+QRect VideoDataOutput::cropRegion(const QRect &cropRect) const
+{
+    const QRect frameRect(0, 0, m_format.width, m_format.height);
+    if (cropRect.isNull() || m_sourceSize.isEmpty())
+        return frameRect;
+
+    // The crop rect is in source pixels, the frame may be scaled.
+    const qreal scaleX = qreal(m_format.width) / m_sourceSize.width();
+    const qreal scaleY = qreal(m_format.height) / m_sourceSize.height();
+    const QRect region = QRectF(cropRect.x() * scaleX, cropRect.y() * scaleY,
+                                cropRect.width() * scaleX, cropRect.height() * scaleY)
+            .toAlignedRect().intersected(frameRect);
+    if (region.isEmpty() || region == frameRect)
+        return region;
+
+    // Chroma is shared by two pixels across, with YV12 also two lines down.
+    const int alignX = m_format.format == VideoFrame2::Format_YV12
+            || m_format.format == VideoFrame2::Format_YUY2 ? 2 : 1;
+    const int alignY = m_format.format == VideoFrame2::Format_YV12 ? 2 : 1;
+    const int left = region.left() / alignX * alignX;
+    const int top = region.top() / alignY * alignY;
+    const int width = (region.right() + 1 - left) / alignX * alignX;
+    const int height = (region.bottom() + 1 - top) / alignY * alignY;
+    return QRect(left, top, qMax(0, width), qMax(0, height));
+}
+
+VideoFrame2 VideoDataOutput::cropFrame(const VideoFrame2 &source, const QRect &region)
+{
+    int index = -1;
+    for (int i = 0; i < m_cropPool.size(); ++i) {
+        const VideoFrame2 &frame = m_cropPool.at(i);
+        if (!isReleased(frame))
+            continue;
+        if (frame.width == region.width() && frame.height == region.height()) {
+            index = i;
+            break;
+        }
+        // Left over from a previous crop region.
+        m_cropPool.removeAt(i--);
+    }
+
+    const int bytes = bytesPerPixel(source.format);
+    const bool planar = source.format == VideoFrame2::Format_YV12;
+    if (index < 0) {
+        VideoFrame2 frame = source;
+        frame.width = region.width();
+        frame.height = region.height();
+        frame.data0 = QByteArray(region.width() * bytes * region.height(), Qt::Uninitialized);
+        const int chromaSize = planar ? (region.width() / 2) * (region.height() / 2) : 0;
+        frame.data1 = QByteArray(chromaSize, Qt::Uninitialized);
+        frame.data2 = QByteArray(chromaSize, Qt::Uninitialized);
+        m_cropPool << frame;
+        index = m_cropPool.size() - 1;
+    }
+
+    VideoFrame2 &frame = m_cropPool[index];
+    copyPlane(source.data0, m_planePitches[0], region.x() * bytes, region.y(),
+              region.width() * bytes, region.height(), &frame.data0);
+    if (planar) {
+        copyPlane(source.data1, m_planePitches[1], region.x() / 2, region.y() / 2,
+                  region.width() / 2, region.height() / 2, &frame.data1);
+        copyPlane(source.data2, m_planePitches[2], region.x() / 2, region.y() / 2,
+                  region.width() / 2, region.height() / 2, &frame.data2);
+    }
+    if (frame.format == VideoFrame2::Format_RGB888) {
+        // Tightly packed, so all rows in one go.
+        swapRedBlue(reinterpret_cast<uchar *>(frame.data0.data()), region.width() * region.height());
+    }
+    return frame;
+}
+
+void VideoDataOutput::queueFrame(const QueuedFrame &frame)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_queue.size() >= m_queueLimit) {
+        ++m_dropped;
+        if (m_dropPolicy == DropNewest)
+            return;
+        m_queue.dequeue();
+    }
+    m_queue.enqueue(frame);
+    m_queueCondition.wakeOne();
+}
+
+void VideoDataOutput::deliverFrames()
+{
+    QMutexLocker lock(&m_mutex);
+    forever {
+        while (m_queue.isEmpty() && !m_stopDelivery)
+            m_queueCondition.wait(&m_mutex);
+        if (m_stopDelivery)
+            return;
+
+        const QueuedFrame queued = m_queue.dequeue();
+        AbstractVideoDataOutput *frontend = m_frontend;
+        if (!frontend)
+            continue;
+        ++m_delivered;
+        m_deliveryLatency.add(LatencyStatistics::now() - queued.captureTime);
+        m_delivering = true;
+        lock.unlock();
+        emit frameTiming(queued.presentationTime, queued.captureTime);
+        frontend->frameReady(queued.frame);
+        lock.relock();
+        m_delivering = false;
+        m_deliveryCondition.wakeAll();
+    }
 }
 
 } // namespace VLC
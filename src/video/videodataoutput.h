@@ -20,19 +20,41 @@
 
 #include <QMutex>
 #include <QObject>
+#include <QQueue>
+#include <QRect>
+#include <QVariantMap>
+#include <QWaitCondition>
 
 #include <phonon/experimental/videodataoutputinterface.h>
 #include <phonon/experimental/videoframe2.h>
 
 #include "sinknode.h"
+#include "latencystatistics.h"
 #include "videomemorystream.h"
 
+class QThread;
+
 namespace Phonon
 {
 namespace VLC
 {
 
 /**
+ * Frames are decoded into a pool of buffers and handed to the frontend on a
+ * delivery thread of their own, so a slow consumer does not stall decoding.
+ * The planes of a VideoFrame2 are implicitly shared, a consumer may keep the
+ * frame it got; its buffers go back to the pool once the last copy is gone.
+ *
+ * Frames waiting for delivery are queued up to queueLimit(), beyond that
+ * the dropPolicy() decides which frame is dropped.
+ *
+ * Consumers needing less than every full frame can have frames skipped,
+ * cropped and scaled down at the source, see setTargetFrameRate(),
+ * setCropRect() and setMaximumSize().
+ *
+ * VideoFrame2 has no room for timing, frameTiming() is emitted right before
+ * each frame is handed to the frontend instead.
+ *
  * @author Harald Sitter <apachelogger@ubuntu.com>
  */
 class VideoDataOutput : public QObject, public SinkNode,
@@ -41,14 +63,69 @@ class VideoDataOutput : public QObject, public SinkNode,
     Q_OBJECT
     Q_INTERFACES(Phonon::Experimental::VideoDataOutputInterface)
 public:
+    /// What to do with a frame when the delivery queue is full.
+    enum DropPolicy {
+        DropOldest, ///< Drop the frame waiting longest, keeps the latency low
+        DropNewest  ///< Drop the new frame, keeps the queued ones in order
+    };
+    Q_ENUM(DropPolicy)
+
     explicit VideoDataOutput(QObject *parent);
     ~VideoDataOutput();
 
+    /// Sets the number of frames waiting for delivery, at least 1.
+    Q_INVOKABLE void setQueueLimit(int limit);
+    Q_INVOKABLE int queueLimit() const;
+
+    Q_INVOKABLE void setDropPolicy(DropPolicy policy);
+    Q_INVOKABLE DropPolicy dropPolicy() const;
+
+    /**
+     * Limits delivery to \p fps frames per second. Frames in between are
+     * skipped right after decoding, before any swapping, cropping or
+     * queueing. 0 delivers all frames.
+     */
+    Q_INVOKABLE void setTargetFrameRate(qreal fps);
+    Q_INVOKABLE qreal targetFrameRate() const;
+
+    /**
+     * Delivers only \p rect of the video, in pixels of its canonical size.
+     * Applies from the next frame on, the region is copied into a tightly
+     * packed frame of its own. A null rect delivers whole frames.
+     */
+    Q_INVOKABLE void setCropRect(const QRect &rect);
+    Q_INVOKABLE QRect cropRect() const;
+
+    /**
+     * Limits delivered frames (the crop rect, if any) to \p size, keeping
+     * the aspect ratio. VLC scales the video before it reaches our buffers,
+     * so this applies from the next format negotiation on. An invalid size
+     * sets no limit.
+     */
+    Q_INVOKABLE void setMaximumSize(const QSize &size);
+    Q_INVOKABLE QSize maximumSize() const;
+
+    /**
+     * Frame counters and latencies:
+     * \li delivered - frames handed to the frontend
+     * \li dropped - frames dropped from a full queue
+     * \li deliveryLatency50, deliveryLatency90, deliveryLatency99 -
+     *     percentiles of the time from the end of decoding to the frontend
+     *     getting the frame over recent frames, in microseconds
+     */
+    Q_INVOKABLE QVariantMap frameStatistics() const;
+
     void handleConnectToMediaObject(MediaObject *mediaObject) override;
     void handleDisconnectFromMediaObject(MediaObject *mediaObject) override;
     void handleAddToMedia(Media *media) override;
+    bool isVideoSink() const override { return true; }
 
     Experimental::AbstractVideoDataOutput *frontendObject() const override;
+    /**
+     * Sets the frontend frames get delivered to. Blocks until a frame being
+     * delivered to the previous frontend was handled, after that it does not
+     * receive frames anymore.
+     */
     void setFrontendObject(Experimental::AbstractVideoDataOutput *frontend) override;
 
     void *lockCallback(void **planes) override;
@@ -61,11 +138,88 @@ public:
                                     unsigned *lines) override;
     void formatCleanUpCallback() override;
 
+Q_SIGNALS:
+    /**
+     * Emitted from the delivery thread right before the frame it describes
+     * is handed to the frontend, connect directly to pair them up.
+     *
+     * \param presentationTime media time the frame is due at in msecs, see
+     *        MediaPlayer::lastTime(); -1 if unknown
+     * \param captureTime when VLC finished decoding the frame, on the
+     *        monotonic clock QElapsedTimer uses, in nanoseconds
+     */
+    void frameTiming(qint64 presentationTime, qint64 captureTime);
+
 private:
+    struct QueuedFrame {
+        Experimental::VideoFrame2 frame;
+        qint64 presentationTime;
+        qint64 captureTime;
+    };
+
+    /// \returns the index of a pool frame no consumer holds anymore
+    int takeFreeFrame();
+
+    /**
+     * \returns the part of the decoded frame to deliver for \p cropRect,
+     * aligned to the chroma subsampling, empty if nothing is left
+     */
+    QRect cropRegion(const QRect &cropRect) const;
+
+    /// Copies \p region of \p source into a frame of the crop pool.
+    Experimental::VideoFrame2 cropFrame(const Experimental::VideoFrame2 &source, const QRect &region);
+
+    /// Queues a frame for delivery, applying the drop policy.
+    void queueFrame(const QueuedFrame &frame);
+
+    /// Delivery thread, hands queued frames to the frontend until stopped.
+    void deliverFrames();
+
     Experimental::AbstractVideoDataOutput *m_frontend;
-    Experimental::VideoFrame2 m_frame;
-    QByteArray m_buffer;
-    QMutex m_mutex;
+
+    // Decoder side, only used by VLC's callbacks.
+    /// Format of the frames, without data.
+    Experimental::VideoFrame2 m_format;
+    /// Sizes of data0 to data2.
+    int m_planeSizes[3];
+    /// Row pitches of data0 to data2.
+    int m_planePitches[3];
+    /// Canonical size of the video, the frames may be scaled down.
+    QSize m_sourceSize;
+    /// Whether VLC's chroma planes are in the reverse VideoFrame2 order.
+    bool m_swapChroma;
+    QList<Experimental::VideoFrame2> m_pool;
+    /// Pool frame VLC decodes into until it got displayed, -1 if none.
+    int m_writeFrame;
+    /// When decoding into the write frame finished.
+    qint64 m_captureTime;
+    /// Whether the write frame is skipped for the target frame rate.
+    bool m_skipFrame;
+    /// Capture time from which on the next frame is due for the target frame rate.
+    qint64 m_nextCaptureTime;
+    /// Region of the write frame to deliver.
+    QRect m_cropRegion;
+    /// Cropped frames, with the sizes of recent crop regions.
+    QList<Experimental::VideoFrame2> m_cropPool;
+
+    // Delivery side, guarded by m_mutex.
+    mutable QMutex m_mutex;
+    QWaitCondition m_queueCondition;
+    QQueue<QueuedFrame> m_queue;
+    int m_queueLimit;
+    DropPolicy m_dropPolicy;
+    qreal m_targetFrameRate;
+    QRect m_cropRect;
+    QSize m_maximumSize;
+    bool m_stopDelivery;
+    /// Whether a frame is being handed to m_frontend outside of m_mutex.
+    bool m_delivering;
+    /// Signalled when a delivery to the frontend finished.
+    QWaitCondition m_deliveryCondition;
+    int m_delivered;
+    int m_dropped;
+    LatencyStatistics m_deliveryLatency;
+    QThread *m_deliveryThread;
 };
 
 } // namespace VLC
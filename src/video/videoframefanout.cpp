@@ -0,0 +1,242 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "videoframefanout.h"
+
+#include <QtCore/QMutexLocker>
+
+#include "utils/debug.h"
+#include "mediaplayer.h"
+#include "video/latencystatistics.h"
+
+namespace Phonon {
+namespace VLC {
+
+VideoFrameFanout *VideoFrameFanout::forPlayer(MediaPlayer *player)
+{
+    VideoFrameFanout *fanout = player->findChild<VideoFrameFanout *>(QString(), Qt::FindDirectChildrenOnly);
+    if (!fanout)
+        fanout = new VideoFrameFanout(player);
+    return fanout;
+}
+
+VideoFrameFanout *VideoFrameFanout::attach(VideoFrameReceiver *receiver, MediaPlayer *player,
+                                           VideoFrameFanout *current)
+{
+    // The MediaObject may have switched to a different player.
+    VideoFrameFanout *fanout = forPlayer(player);
+    if (fanout != current) {
+        if (current)
+            current->removeReceiver(receiver);
+        fanout->addReceiver(receiver);
+    }
+    fanout->setCallbacks(player);
+    return fanout;
+}
+
+VideoFrameFanout::VideoFrameFanout(MediaPlayer *player)
+    : QObject(player)
+    , m_player(player)
+    , m_bufferSize(0)
+    , m_swapChroma(false)
+{
+    m_format.layout = YuvConverter::Planar;
+    for (int plane = 0; plane < 3; ++plane) {
+        m_format.planes[plane] = 0;
+        m_format.pitches[plane] = 0;
+        m_planeOffsets[plane] = 0;
+    }
+}
+
+void VideoFrameFanout::addReceiver(VideoFrameReceiver *receiver)
+{
+    QMutexLocker lock(&m_receiverMutex);
+    if (!m_receivers.contains(receiver))
+        m_receivers << receiver;
+}
+
+void VideoFrameFanout::removeReceiver(VideoFrameReceiver *receiver)
+{
+    QMutexLocker lock(&m_receiverMutex);
+    m_receivers.removeAll(receiver);
+}
+
+bool VideoFrameFanout::hasReceivers() const
+{
+    QMutexLocker lock(&m_receiverMutex);
+    return !m_receivers.isEmpty();
+}
+
+void *VideoFrameFanout::lockCallback(void **planes)
+{
+    // Like the single painter ring, VLC decodes into the write frame until
+    // it got displayed.
+    if (!m_writeFrame)
+        m_writeFrame = takeFreeFrame();
+    char *data = m_writeFrame->buffer.data();
+    for (int plane = 0; plane < 3; ++plane) {
+        planes[plane] = m_planeOffsets[plane] >= 0 ? data + m_planeOffsets[plane] : 0;
+    }
+    return 0;
+}
+
+void VideoFrameFanout::unlockCallback(void *picture, void *const *planes)
+{
+    Q_UNUSED(picture);
+    Q_UNUSED(planes);
+    if (m_writeFrame)
+        m_writeFrame->captureTime = LatencyStatistics::now();
+}
+
+void VideoFrameFanout::displayCallback(void *picture)
+{
+    Q_UNUSED(picture);
+    if (!m_writeFrame)
+        return;
+
+    // Receivers hold on to the displayed frame, decode into another one.
+    // With all of them held the frame is dropped and decoded over instead.
+    SharedVideoFramePtr next = takeFreeFrame();
+    if (!next)
+        return;
+
+    m_writeFrame->displayed.start();
+    // VLC displays frames on the playback clock, so this is the frame's
+    // presentation time within a few milliseconds.
+    m_writeFrame->presentationTime = m_player->lastTime();
+    {
+        QMutexLocker lock(&m_receiverMutex);
+        foreach (VideoFrameReceiver *receiver, m_receivers) {
+            receiver->presentFrame(m_writeFrame);
+        }
+    }
+    m_writeFrame = next;
+}
+
+unsigned VideoFrameFanout::formatCallback(char *chroma,
+                                          unsigned *width, unsigned *height,
+                                          unsigned *pitches,
+                                          unsigned *lines)
+{
+    // Frames are kept in 4:2:0 YUV and scaled and converted to RGB by each
+    // receiver at paint time, see YuvConverter. Since aspect ratio can be
+    // changed mid-playback by the user, doing the scaling on our end means we
+    // don't need to restart the entire player to retrigger format calculation.
+    // The planes are laid out like VLC's own pictures, so it can copy its
+    // output straight in.
+    m_sourceSize = QSize(*width, *height);
+    QSize size = m_sourceSize;
+    vlc_fourcc_t fourcc = VLC_FOURCC(chroma[0], chroma[1], chroma[2], chroma[3]);
+    if (fourcc != VLC_CODEC_I420 && fourcc != VLC_CODEC_YV12 && fourcc != VLC_CODEC_NV12) {
+        // VLC converts anything else to I420 for us. Since that filter runs
+        // anyway it may as well reduce frames larger than any receiver's
+        // screen, they are wasted. Growing a widget up to the screen size
+        // costs no quality this way, so no renegotiation (which libvlc does
+        // not offer short of restarting the input) is needed on resizes.
+        // Decoder output is taken at its canonical size though, asking for a
+        // smaller size would add a scaler that costs more than it saves.
+        fourcc = VLC_CODEC_I420;
+        qstrcpy(chroma, "I420");
+
+        QSize maximumSize;
+        {
+            QMutexLocker lock(&m_receiverMutex);
+            foreach (VideoFrameReceiver *receiver, m_receivers) {
+                const QSize receiverSize = receiver->maximumFrameSize();
+                if (!receiverSize.isValid()) {
+                    maximumSize = QSize();
+                    break;
+                }
+                maximumSize = maximumSize.expandedTo(receiverSize);
+            }
+        }
+        if (maximumSize.isValid()
+                && (size.width() > maximumSize.width()
+                    || size.height() > maximumSize.height())) {
+            size = size.scaled(maximumSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+            debug() << "scaling" << m_sourceSize << "frames down to" << size;
+        }
+    }
+    *width = size.width();
+    *height = size.height();
+
+    m_bufferSize = setPitchAndLines(fourcc, *width, *height, pitches, lines);
+    const int planeCount = fourcc == VLC_CODEC_NV12 ? 2 : 3;
+    m_format.size = size;
+    m_format.layout = planeCount == 2 ? YuvConverter::SemiPlanar : YuvConverter::Planar;
+    m_swapChroma = fourcc == VLC_CODEC_YV12;
+    int offset = 0;
+    for (int plane = 0; plane < 3; ++plane) {
+        m_format.pitches[plane] = plane < planeCount ? pitches[plane] : 0;
+        m_planeOffsets[plane] = plane < planeCount ? offset : -1;
+        if (plane < planeCount)
+            offset += pitches[plane] * lines[plane];
+    }
+
+    // Frames of the old format stay valid for the receivers holding them.
+    m_pool.clear();
+    m_writeFrame.reset();
+
+    return m_bufferSize;
+}
+
+void VideoFrameFanout::formatCleanUpCallback()
+{
+    m_pool.clear();
+    m_writeFrame.reset();
+}
+
+SharedVideoFramePtr VideoFrameFanout::takeFreeFrame()
+{
+    foreach (const SharedVideoFramePtr &frame, m_pool) {
+        // Only referenced by the pool.
+        if (frame->ref.loadAcquire() == 1)
+            return frame;
+    }
+
+    // One frame being decoded, one being shown and one more per receiver
+    // to queue or convert. Beyond that a receiver is not keeping up and
+    // more buffers would only pile up.
+    int maximumFrames = 2;
+    {
+        QMutexLocker lock(&m_receiverMutex);
+        maximumFrames += m_receivers.size();
+    }
+    if (m_pool.size() >= maximumFrames)
+        return SharedVideoFramePtr();
+
+    SharedVideoFramePtr frame(new SharedVideoFrame);
+    frame->buffer = QByteArray(m_bufferSize, Qt::Uninitialized);
+    frame->frame = m_format;
+    frame->sourceSize = m_sourceSize;
+    frame->presentationTime = -1;
+    frame->captureTime = LatencyStatistics::now();
+    uchar *data = reinterpret_cast<uchar *>(frame->buffer.data());
+    for (int plane = 0; plane < 3; ++plane) {
+        frame->frame.planes[plane] = m_planeOffsets[plane] >= 0 ? data + m_planeOffsets[plane] : 0;
+    }
+    if (m_swapChroma) {
+        // YV12 has V before U.
+        qSwap(frame->frame.planes[1], frame->frame.planes[2]);
+        qSwap(frame->frame.pitches[1], frame->frame.pitches[2]);
+    }
+    m_pool << frame;
+    return frame;
+}
+
+} // namespace VLC
+} // namespace Phonon
@@ -0,0 +1,155 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_VLC_VIDEOFRAMEFANOUT_H
+#define PHONON_VLC_VIDEOFRAMEFANOUT_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QExplicitlySharedDataPointer>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QSharedData>
+#include <QtCore/QSize>
+
+#include "videomemorystream.h"
+#include "yuvconverter.h"
+
+namespace Phonon {
+namespace VLC {
+
+/**
+ * A decoded 4:2:0 YUV frame. Receivers get it read-only and may hold on to
+ * it as long as they like, the fan-out only decodes into frames nobody else
+ * references.
+ */
+class SharedVideoFrame : public QSharedData
+{
+public:
+    /// Planes point into buffer.
+    YuvConverter::Frame frame;
+    /// Canonical size of the video, the frame may be smaller.
+    QSize sourceSize;
+    /// Started when the frame was due for display.
+    QElapsedTimer displayed;
+    /// Media time at display in msecs, see MediaPlayer::lastTime(); -1 if unknown.
+    qint64 presentationTime;
+    /// When VLC finished decoding it, see LatencyStatistics::now().
+    qint64 captureTime;
+    QByteArray buffer;
+};
+
+typedef QExplicitlySharedDataPointer<SharedVideoFrame> SharedVideoFramePtr;
+
+/// Consumer of the frames of a VideoFrameFanout.
+class VideoFrameReceiver
+{
+public:
+    virtual ~VideoFrameReceiver() {}
+
+    /**
+     * Called from VLC's vout thread for every frame due for display. Must
+     * not block, the next frame is decoded only once this returns.
+     */
+    virtual void presentFrame(const SharedVideoFramePtr &frame) = 0;
+
+    /// \returns the largest frame size worth producing, invalid for no limit
+    virtual QSize maximumFrameSize() const = 0;
+};
+
+/** \brief Shares the decoded frames of one player with any number of receivers
+ *
+ * A player only has one set of memory callbacks, so without this every
+ * VideoWidget would need its own player decoding the same media. The fan-out
+ * holds the callbacks instead and hands each frame to all receivers, which
+ * scale and convert it independently.
+ *
+ * Frames are reference counted and recycled once no receiver holds them
+ * anymore, so receivers never need a copy. The pool is bounded: once
+ * receivers hold all frames, new ones get dropped until a frame is released.
+ * There is one fan-out per player, living as its child so it outlives
+ * the vout.
+ */
+class VideoFrameFanout : public QObject, public VideoMemoryStream
+{
+    Q_OBJECT
+public:
+    /// \returns the fan-out of \p player, created on first use
+    static VideoFrameFanout *forPlayer(MediaPlayer *player);
+
+    /**
+     * Makes \p receiver get the frames of \p player, leaving \p current if
+     * that is a different fan-out, and (re)sets the player's callbacks. For
+     * sinks to call when added to a media.
+     *
+     * \returns the fan-out of \p player
+     */
+    static VideoFrameFanout *attach(VideoFrameReceiver *receiver, MediaPlayer *player,
+                                    VideoFrameFanout *current);
+
+    /**
+     * Adds \p receiver, it gets all frames displayed from now on. Its maximum
+     * size applies from the next format negotiation on.
+     */
+    void addReceiver(VideoFrameReceiver *receiver);
+
+    /// Removes \p receiver, it is not called anymore once this returns.
+    void removeReceiver(VideoFrameReceiver *receiver);
+
+    /// \returns whether any receiver gets the frames
+    bool hasReceivers() const;
+
+private:
+    explicit VideoFrameFanout(MediaPlayer *player);
+
+    void *lockCallback(void **planes) override;
+    void unlockCallback(void *picture, void *const *planes) override;
+    void displayCallback(void *picture) override;
+    unsigned formatCallback(char *chroma,
+                            unsigned *width, unsigned *height,
+                            unsigned *pitches,
+                            unsigned *lines) override;
+    void formatCleanUpCallback() override;
+
+    /**
+     * \returns a frame of the current format nobody but the pool references,
+     * null if receivers hold all frames the pool may have
+     */
+    SharedVideoFramePtr takeFreeFrame();
+
+    MediaPlayer *m_player;
+
+    mutable QMutex m_receiverMutex;
+    QList<VideoFrameReceiver *> m_receivers;
+
+    // Only touched by VLC's vout thread.
+    QList<SharedVideoFramePtr> m_pool;
+    SharedVideoFramePtr m_writeFrame;
+    /// Format of new frames, their planes start at m_planeOffsets.
+    YuvConverter::Frame m_format;
+    /// In VLC's plane order, -1 for planes the chroma does not have.
+    int m_planeOffsets[3];
+    QSize m_sourceSize;
+    unsigned m_bufferSize;
+    bool m_swapChroma;
+};
+
+} // namespace VLC
+} // namespace Phonon
+
+#endif // PHONON_VLC_VIDEOFRAMEFANOUT_H
@@ -0,0 +1,174 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "videoitem.h"
+
+#include <QtCore/QMutexLocker>
+#include <QtGui/QPainter>
+#include <QtGui/QScreen>
+#include <QtQuick/QQuickWindow>
+#include <QtQuick/QSGRendererInterface>
+
+#include "utils/debug.h"
+#include "mediaobject.h"
+#include "mediaplayer.h"
+
+namespace Phonon {
+namespace VLC {
+
+VideoItem::VideoItem(QQuickItem *parent)
+    : QQuickPaintedItem(parent)
+    , SinkNode()
+{
+    // Opaque painting gives an RGB32 backing image, the converter's format.
+    setOpaquePainting(true);
+    setFillColor(Qt::black);
+    setRenderTarget(QQuickPaintedItem::Image);
+}
+
+VideoItem::~VideoItem()
+{
+    if (m_frameFanout)
+        m_frameFanout->removeReceiver(this);
+}
+
+void VideoItem::handleConnectToMediaObject(MediaObject *mediaObject)
+{
+    connect(mediaObject, SIGNAL(hasVideoChanged(bool)),
+            SLOT(updateVideoSize(bool)));
+}
+
+void VideoItem::handleDisconnectFromMediaObject(MediaObject *mediaObject)
+{
+    disconnect(mediaObject, 0, this, 0);
+
+    if (m_frameFanout) {
+        m_frameFanout->removeReceiver(this);
+        m_frameFanout = 0;
+    }
+}
+
+void VideoItem::handleAddToMedia(Media *media)
+{
+    if (m_mediaObject && m_mediaObject->isAudioOnly())
+        return;
+
+    media->addOption(":video");
+
+    m_frameFanout = VideoFrameFanout::attach(this, m_player, m_frameFanout);
+}
+
+void VideoItem::paint(QPainter *painter)
+{
+    // Frames presented from here on need another update.
+    m_updatePending.storeRelease(0);
+    {
+        QMutexLocker lock(&m_frameMutex);
+        if (m_latestFrame) {
+            m_displayFrame = m_latestFrame;
+            m_latestFrame.reset();
+        }
+    }
+    if (!m_displayFrame)
+        return;
+
+    const QRectF target = frameRect(m_displayFrame->sourceSize);
+    if (target.isEmpty())
+        return;
+
+    // With a hardware scene graph the device is the image backing the item's
+    // texture, convert right into it. The software scene graph paints into
+    // the window, where other items may overlap, so draw it regularly there.
+    QImage *surface = painter->device()->devType() == QInternal::Image
+            ? static_cast<QImage *>(painter->device()) : 0;
+    if (surface && !isSoftwareRendered(window())
+            && surface->format() == QImage::Format_RGB32
+            && painter->transform().type() <= QTransform::TxScale) {
+        const QRect deviceRect = painter->transform().mapRect(target).toAlignedRect()
+                .intersected(surface->rect());
+        if (!deviceRect.isEmpty()) {
+            // A view into the surface, it shares the bits.
+            QImage view(surface->bits() + deviceRect.y() * surface->bytesPerLine() + deviceRect.x() * 4,
+                        deviceRect.width(), deviceRect.height(), surface->bytesPerLine(),
+                        QImage::Format_RGB32);
+            m_converter.convert(m_displayFrame->frame, &view);
+        }
+        return;
+    }
+
+    const QSize size = painter->transform().mapRect(target).toAlignedRect().size().expandedTo(QSize(1, 1));
+    if (m_scaledFrame.size() != size)
+        m_scaledFrame = QImage(size, QImage::Format_RGB32);
+    m_converter.convert(m_displayFrame->frame, &m_scaledFrame);
+    painter->drawImage(target, m_scaledFrame);
+}
+
+void VideoItem::itemChange(ItemChange change, const ItemChangeData &value)
+{
+    if (change == ItemSceneChange && value.window && isSoftwareRendered(value.window))
+        debug() << "software scene graph, blitting frames";
+    if (change == ItemSceneChange && value.window && value.window->screen()) {
+        // Frames beyond the screen's size are wasted, see VideoFrameFanout.
+        QScreen *screen = value.window->screen();
+        QMutexLocker lock(&m_frameMutex);
+        m_maximumFrameSize = screen->size() * screen->devicePixelRatio();
+    }
+    QQuickPaintedItem::itemChange(change, value);
+}
+
+void VideoItem::updateVideoSize(bool hasVideo)
+{
+    if (hasVideo)
+        setImplicitSize(m_player->videoSize().width(), m_player->videoSize().height());
+}
+
+void VideoItem::presentFrame(const SharedVideoFramePtr &frame)
+{
+    {
+        QMutexLocker lock(&m_frameMutex);
+        m_latestFrame = frame;
+    }
+    // The scene graph paces updates to the display, one request is enough.
+    if (m_updatePending.testAndSetAcquire(0, 1))
+        QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+}
+
+bool VideoItem::isSoftwareRendered(QQuickWindow *window)
+{
+    if (!window)
+        return false;
+    // The renderer interface only exists once the scene graph is up, the
+    // backend name is known before.
+    if (QSGRendererInterface *renderer = window->rendererInterface())
+        return renderer->graphicsApi() == QSGRendererInterface::Software;
+    return QQuickWindow::sceneGraphBackend() == QLatin1String("software");
+}
+
+QSize VideoItem::maximumFrameSize() const
+{
+    QMutexLocker lock(&m_frameMutex);
+    return m_maximumFrameSize;
+}
+
+QRectF VideoItem::frameRect(const QSize &sourceSize) const
+{
+    const QSizeF size = QSizeF(sourceSize).scaled(QSizeF(width(), height()), Qt::KeepAspectRatio);
+    return QRectF(QPointF((width() - size.width()) / 2.0, (height() - size.height()) / 2.0), size);
+}
+
+} // namespace VLC
+} // namespace Phonon
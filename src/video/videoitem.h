@@ -0,0 +1,104 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_VLC_VIDEOITEM_H
+#define PHONON_VLC_VIDEOITEM_H
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <QtCore/QPointer>
+#include <QtGui/QImage>
+#include <QtQuick/QQuickPaintedItem>
+
+#include "sinknode.h"
+#include "videoframefanout.h"
+#include "yuvconverter.h"
+
+namespace Phonon {
+namespace VLC {
+
+/** \brief Qt Quick video sink
+ *
+ * Created for Phonon's VideoGraphicsObjectClass and connected to a
+ * MediaObject like any other sink (Backend::connectNodes()), then parented
+ * into a scene like any QQuickItem. The item is not registered with QML,
+ * there is no way to connect it to a MediaObject from there. Applications
+ * create it from C++ through Backend::createObject(), passing the QQuickItem
+ * it is to show in as parent (or calling setParentItem() later), and can
+ * hand it to QML as a context property from there.
+ *
+ * Frames come from the player's VideoFrameFanout and are scaled and converted
+ * at paint time, like the VideoWidget surface painter does. The item paints
+ * into the image QQuickPaintedItem keeps for its texture, so neither the image
+ * nor the texture is reallocated per frame; with the OpenGL/RHI scene graph
+ * the conversion writes straight into that image. On the software scene graph
+ * the converted frame is drawn as a plain blit, so no GPU is needed; run
+ * with QT_QUICK_BACKEND=software to check that path.
+ */
+class VideoItem : public QQuickPaintedItem, public SinkNode, private VideoFrameReceiver
+{
+    Q_OBJECT
+public:
+    explicit VideoItem(QQuickItem *parent = nullptr);
+    ~VideoItem();
+
+    void handleConnectToMediaObject(MediaObject *mediaObject) override;
+    void handleDisconnectFromMediaObject(MediaObject *mediaObject) override;
+    void handleAddToMedia(Media *media) override;
+    bool isVideoSink() const override { return true; }
+
+    /// \reimp
+    void paint(QPainter *painter) override;
+
+protected:
+    /// \reimp
+    void itemChange(ItemChange change, const ItemChangeData &value) override;
+
+private Q_SLOTS:
+    /// Sets the implicit size to the native size of the video.
+    void updateVideoSize(bool hasVideo);
+
+private:
+    /// \returns whether \p window renders with the software scene graph
+    static bool isSoftwareRendered(QQuickWindow *window);
+
+    void presentFrame(const SharedVideoFramePtr &frame) override;
+    QSize maximumFrameSize() const override;
+
+    /// \returns the rect the frame covers, keeping its aspect
+    QRectF frameRect(const QSize &sourceSize) const;
+
+    QPointer<VideoFrameFanout> m_frameFanout;
+
+    /// Guards the frame handover with VLC's vout thread.
+    mutable QMutex m_frameMutex;
+    SharedVideoFramePtr m_latestFrame;
+    QSize m_maximumFrameSize;
+    /// Set while an update is requested but did not happen yet.
+    QAtomicInt m_updatePending;
+
+    // Render thread only (GUI thread blocked meanwhile).
+    SharedVideoFramePtr m_displayFrame;
+    YuvConverter m_converter;
+    /// Conversion target when the paint device can not be written directly.
+    QImage m_scaledFrame;
+};
+
+} // namespace VLC
+} // namespace Phonon
+
+#endif // PHONON_VLC_VIDEOITEM_H
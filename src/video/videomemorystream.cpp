@@ -43,15 +43,27 @@ unsigned VideoMemoryStream::setPitchAndLines(uint32_t fourcc,
 {
     // Fairly unclear what the last two arguments do, they seem to make no diff for the planes though, so I guess they can be anything in our case.
     const auto picture = picture_New(fourcc, width, height, 0, 1);
+    if (!picture) {
+        error() << "unsupported chroma" << QByteArray(reinterpret_cast<const char *>(&fourcc), 4);
+        pitches[0] = lines[0] = 0;
+        return 0;
+    }
 
     unsigned bufferSize = 0;
 
-    for (auto i = 0; i < picture->i_planes; ++i) {
+    auto i = 0;
+    for (; i < picture->i_planes; ++i) {
         const auto plane = picture->p[i];
         pitches[i] = plane.i_visible_pitch;
         lines[i] = plane.i_visible_lines;
         bufferSize += (pitches[i] * lines[i]);
     }
+    // VLC leaves the tables uninitialized, unused planes are terminated by 0.
+    for (; i < PICTURE_PLANE_MAX; ++i) {
+        pitches[i] = lines[i] = 0;
+    }
+
+    picture_Release(picture);
 
     return bufferSize;
 }
@@ -107,7 +119,7 @@ unsigned VideoMemoryStream::formatCallbackInternal(void **opaque, char *chroma,
         QStringList lineValues;
         unsigned *pitch = pitches;
         unsigned *line = lines;
-        for (; *pitch != 0; ++pitch) {
+        for (; *pitch != 0; ++pitch, ++line) {
             Q_ASSERT(lines != 0); // pitch and line tables ought to be the same size
             pitchValues << QString::number(*pitch);
             lineValues << QString::number(*line);
@@ -0,0 +1,161 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "videosinkoutput.h"
+
+#include <memory>
+
+#include <QtCore/QMutexLocker>
+#include <QtMultimedia/QAbstractVideoBuffer>
+#include <QtMultimedia/QVideoFrame>
+#include <QtMultimedia/QVideoFrameFormat>
+
+#include "utils/debug.h"
+#include "mediaobject.h"
+
+namespace Phonon {
+namespace VLC {
+
+/**
+ * Read-only QVideoFrame buffer over a decoded frame. Holding the reference
+ * keeps the fan-out from decoding into it until Qt Multimedia is done.
+ */
+class SharedFrameVideoBuffer : public QAbstractVideoBuffer
+{
+public:
+    explicit SharedFrameVideoBuffer(const SharedVideoFramePtr &frame)
+        : m_frame(frame)
+    {
+        const YuvConverter::Frame &data = m_frame->frame;
+        m_format = QVideoFrameFormat(data.size,
+                                     data.layout == YuvConverter::SemiPlanar
+                                     ? QVideoFrameFormat::Format_NV12
+                                     : QVideoFrameFormat::Format_YUV420P);
+        // Same guess as the painted paths, the frames do not carry VLC's
+        // colour space.
+        m_format.setColorSpace(YuvConverter::colorSpace(data.size) == YuvConverter::BT709
+                               ? QVideoFrameFormat::ColorSpace_BT709
+                               : QVideoFrameFormat::ColorSpace_BT601);
+        m_format.setColorRange(QVideoFrameFormat::ColorRange_Video);
+    }
+
+    MapData map(QVideoFrame::MapMode mode) override
+    {
+        MapData mapData;
+        if (mode & QVideoFrame::WriteOnly) {
+            // Other receivers see the same frame.
+            return mapData;
+        }
+
+        const YuvConverter::Frame &data = m_frame->frame;
+        const int chromaRows = (data.size.height() + 1) / 2;
+        mapData.planeCount = data.layout == YuvConverter::SemiPlanar ? 2 : 3;
+        for (int plane = 0; plane < mapData.planeCount; ++plane) {
+            mapData.data[plane] = const_cast<uchar *>(data.planes[plane]);
+            mapData.bytesPerLine[plane] = data.pitches[plane];
+            mapData.dataSize[plane] = data.pitches[plane] * (plane == 0 ? data.size.height() : chromaRows);
+        }
+        return mapData;
+    }
+
+    QVideoFrameFormat format() const override
+    {
+        return m_format;
+    }
+
+private:
+    SharedVideoFramePtr m_frame;
+    QVideoFrameFormat m_format;
+};
+
+VideoSinkOutput::VideoSinkOutput(QObject *parent)
+    : QObject(parent)
+    , SinkNode()
+{
+}
+
+VideoSinkOutput::~VideoSinkOutput()
+{
+    if (m_frameFanout)
+        m_frameFanout->removeReceiver(this);
+}
+
+void VideoSinkOutput::setVideoSink(QVideoSink *sink)
+{
+    m_videoSink = sink;
+}
+
+QVideoSink *VideoSinkOutput::videoSink() const
+{
+    return m_videoSink;
+}
+
+void VideoSinkOutput::handleDisconnectFromMediaObject(MediaObject *mediaObject)
+{
+    Q_UNUSED(mediaObject);
+    if (m_frameFanout) {
+        m_frameFanout->removeReceiver(this);
+        m_frameFanout = 0;
+    }
+}
+
+void VideoSinkOutput::handleAddToMedia(Media *media)
+{
+    if (m_mediaObject && m_mediaObject->isAudioOnly())
+        return;
+
+    media->addOption(":video");
+    m_frameFanout = VideoFrameFanout::attach(this, m_player, m_frameFanout);
+}
+
+void VideoSinkOutput::deliverFrame()
+{
+    SharedVideoFramePtr frame;
+    {
+        QMutexLocker lock(&m_frameMutex);
+        frame.swap(m_pendingFrame);
+    }
+    if (!frame || !m_videoSink)
+        return;
+
+    QVideoFrame videoFrame(std::make_unique<SharedFrameVideoBuffer>(frame));
+    if (frame->presentationTime >= 0)
+        videoFrame.setStartTime(frame->presentationTime * 1000);
+    m_videoSink->setVideoFrame(videoFrame);
+}
+
+void VideoSinkOutput::presentFrame(const SharedVideoFramePtr &frame)
+{
+    bool pending;
+    {
+        QMutexLocker lock(&m_frameMutex);
+        pending = bool(m_pendingFrame);
+        m_pendingFrame = frame;
+    }
+    // A frame still waiting gets replaced, its delivery picks up this one.
+    if (!pending)
+        QMetaObject::invokeMethod(this, "deliverFrame", Qt::QueuedConnection);
+}
+
+QSize VideoSinkOutput::maximumFrameSize() const
+{
+    // The consumer decides what to do with the frames, keep them as decoded.
+    return QSize();
+}
+
+} // namespace VLC
+} // namespace Phonon
@@ -0,0 +1,79 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_VLC_VIDEOSINKOUTPUT_H
+#define PHONON_VLC_VIDEOSINKOUTPUT_H
+
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtMultimedia/QVideoSink>
+
+#include "sinknode.h"
+#include "videoframefanout.h"
+
+namespace Phonon {
+namespace VLC {
+
+/** \brief Feeds decoded frames into a Qt Multimedia QVideoSink
+ *
+ * Created through Backend::createVideoSinkOutput() and connected to a
+ * MediaObject like any other sink (Backend::connectNodes()).
+ *
+ * Frames come from the player's VideoFrameFanout and are handed over as
+ * QVideoFrames in their decoded YUV 4:2:0 format (YUV420P or NV12), without
+ * any conversion or copy. Each QVideoFrame references the decoded frame, so
+ * its buffer goes back to the fan-out's pool once Qt Multimedia released it.
+ *
+ * Frames are delivered on the thread of this object. Should a frame still
+ * be waiting when the next one is decoded, it is replaced.
+ */
+class VideoSinkOutput : public QObject, public SinkNode, private VideoFrameReceiver
+{
+    Q_OBJECT
+public:
+    explicit VideoSinkOutput(QObject *parent = nullptr);
+    ~VideoSinkOutput();
+
+    /// Sets the QVideoSink to feed, nullptr to stop.
+    Q_INVOKABLE void setVideoSink(QVideoSink *sink);
+    Q_INVOKABLE QVideoSink *videoSink() const;
+
+    void handleDisconnectFromMediaObject(MediaObject *mediaObject) override;
+    void handleAddToMedia(Media *media) override;
+    bool isVideoSink() const override { return true; }
+
+private Q_SLOTS:
+    /// Hands the latest frame to the sink.
+    void deliverFrame();
+
+private:
+    void presentFrame(const SharedVideoFramePtr &frame) override;
+    QSize maximumFrameSize() const override;
+
+    QPointer<QVideoSink> m_videoSink;
+    QPointer<VideoFrameFanout> m_frameFanout;
+
+    QMutex m_frameMutex;
+    /// Decoded but not delivered yet.
+    SharedVideoFramePtr m_pendingFrame;
+};
+
+} // namespace VLC
+} // namespace Phonon
+
+#endif // PHONON_VLC_VIDEOSINKOUTPUT_H
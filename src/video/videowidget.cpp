@@ -21,9 +21,14 @@
 
 #include "videowidget.h"
 
+#include <QAtomicInt>
+#include <QElapsedTimer>
 #include <QGuiApplication>
 #include <QPainter>
 #include <QPaintEvent>
+#include <QScreen>
+#include <QTimer>
+#include <QtMath>
 
 #include <vlc/vlc.h>
 
@@ -31,105 +36,170 @@
 #include "mediaobject.h"
 #include "media.h"
 
-#include "video/videomemorystream.h"
+#include "video/latencystatistics.h"
+#include "video/performanceoverlay.h"
+#include "video/videoframefanout.h"
+#include "video/yuvconverter.h"
 
 namespace Phonon {
 namespace VLC {
 
 #define DEFAULT_QSIZE QSize(320, 240)
+#define DEFAULT_REFRESH_RATE 60.0
 
-class SurfacePainter : public VideoMemoryStream
+// Weight of the newest sample in the paint statistics averages is 1/n.
+#define STATISTICS_SMOOTHING 16
+
+class SurfacePainter : public VideoFrameReceiver
 {
 public:
+    SurfacePainter()
+        : widget(0)
+        , m_fresh(false)
+        , m_refreshInterval(qint64(1000000000 / DEFAULT_REFRESH_RATE))
+        , m_paintTime(0)
+        , m_presentDelay(0)
+    {
+    }
+
     void handlePaint(QPaintEvent *event)
     {
-        // Mind that locking here is still faster than making this lockfree by
-        // dispatching QEvents.
-        // Plus VLC can actually skip frames as necessary.
-        QMutexLocker lock(&m_mutex);
-        Q_UNUSED(event);
+        QElapsedTimer paintTimer;
+        paintTimer.start();
+
+        // Frames presented from here on need another paint.
+        m_updatePending.storeRelease(0);
+
+        // Take the latest frame, if there is a new one. The previous one
+        // goes back to the fan-out once nobody else holds it either.
+        bool fresh = false;
+        {
+            QMutexLocker lock(&m_frameMutex);
+            if (m_fresh) {
+                m_displayFrame = m_latestFrame;
+                m_latestFrame.reset();
+                m_fresh = false;
+                m_painted.ref();
+                const qint64 delay = m_displayFrame->displayed.nsecsElapsed();
+                if (delay > m_refreshInterval)
+                    m_late.ref();
+                m_presentDelay += (delay - m_presentDelay) / STATISTICS_SMOOTHING;
+                fresh = true;
+            }
+        }
 
-        if (m_frame.isNull()) {
+        if (!m_displayFrame) {
             return;
         }
 
+        // Convert straight to the painted size, drawing is a plain blit then.
+        // Writing through bits() changes the image's cache key, so paint
+        // engines caching textures (OpenGL) pick up every new frame.
+        const QRect target = drawFrameRect();
+        const qreal ratio = widget->devicePixelRatioF();
+        const QSize size = (QSizeF(target.size()) * ratio).toSize().expandedTo(QSize(1, 1));
+        if (m_scaledFrame.size() != size) {
+            m_scaledFrame = QImage(size, QImage::Format_RGB32);
+            m_scaledFrame.setDevicePixelRatio(ratio);
+        }
+        m_converter.convert(m_displayFrame->frame, &m_scaledFrame);
+
         QPainter painter(widget);
-        // When using OpenGL for the QPaintEngine drawing the same QImage twice
-        // does not actually result in a texture change for one reason or another.
-        // So we simply create new images for every event. This is plenty cheap
-        // as the QImage only points to the plane data (it can't even make it
-        // properly shared as it does not know that the data belongs to a QBA).
-        // TODO: investigate if this is still necessary. This was added for gwenview, but with Qt 5.15 the problem
-        //   can't be produced.
-        painter.drawImage(drawFrameRect(), QImage(m_frame));
+        painter.drawImage(target, m_scaledFrame);
         event->accept();
+
+        m_paintTime += (paintTimer.nsecsElapsed() - m_paintTime) / STATISTICS_SMOOTHING;
+        if (fresh)
+            m_paintLatency.add(LatencyStatistics::now() - m_displayFrame->captureTime);
     }
 
-    VideoWidget *widget;
+    /**
+     * \returns the latest frame at its decoded size, a null image if there
+     * was none yet
+     */
+    QImage snapshot()
+    {
+        SharedVideoFramePtr frame;
+        {
+            QMutexLocker lock(&m_frameMutex);
+            frame = m_fresh ? m_latestFrame : m_displayFrame;
+        }
+        if (!frame)
+            return QImage();
 
-private:
-    void *lockCallback(void **planes) override
+        QImage image(frame->frame.size, QImage::Format_RGB32);
+        m_converter.convert(frame->frame, &image);
+        return image;
+    }
+
+    /**
+     * Sets the picture adjustments, in Phonon ranges. They are applied as
+     * part of the conversion, starting with the next paint.
+     */
+    void setAdjust(qreal brightness, qreal contrast, qreal hue, qreal saturation)
     {
-        m_mutex.lock();
-        planes[0] = (void *) m_frame.bits();
-        return 0;
+        m_converter.setAdjust(brightness, contrast, hue, saturation);
     }
 
-    void unlockCallback(void *picture,void *const *planes) override
+    /**
+     * Sets the largest frame size, in device pixels, worth having VLC scale
+     * to. Applies from the next format negotiation on.
+     */
+    void setMaximumFrameSize(const QSize &size)
     {
-        Q_UNUSED(picture);
-        Q_UNUSED(planes);
-        m_mutex.unlock();
+        QMutexLocker lock(&m_frameMutex);
+        m_maximumFrameSize = size;
     }
 
-    void displayCallback(void *picture) override
+    /// Frames taking longer than a refresh from display to paint are late.
+    void setRefreshRate(qreal rate)
     {
-        Q_UNUSED(picture);
-        if (widget)
-            widget->update();
+        m_refreshInterval = qint64(1000000000 / rate);
     }
 
-    unsigned formatCallback(char *chroma,
-                                    unsigned *width, unsigned *height,
-                                    unsigned *pitches,
-                                    unsigned *lines) override
+    QVariantMap statistics() const
     {
-        QMutexLocker lock(&m_mutex);
-        // Surface rendering is a fallback system used when no efficient rendering implementation is available.
-        // As such we only support RGB32 for simplicity reasons and this will almost always mean software scaling.
-        // And since scaling is unavoidable anyway we take the canonical frame size and then scale it on our end via
-        // QPainter, again, greater simplicity at likely no real extra cost since this is all super inefficient anyway.
-        // Also, since aspect ratio can be change mid-playback by the user, doing the scaling on our end means we
-        // don't need to restart the entire player to retrigger format calculation.
-        // With all that in mind we simply use the canonical size and feed VLC the QImage's pitch and lines as
-        // effectively the VLC vout is the QImage so its constraints matter.
-
-        // per https://wiki.videolan.org/Hacker_Guide/Video_Filters/#Pitch.2C_visible_pitch.2C_planes_et_al.
-        // it would seem that we can use either real or visible pitches and lines as VLC generally will iterate the
-        // smallest value when moving data between two entities. i.e. since QImage will at most paint NxM anyway,
-        // we may just go with its values as calculating the real pitch/line of the VLC picture_t for RV32 wouldn't
-        // change the maximum pitch/lines we can paint on the output side.
-
-        qstrcpy(chroma, "RV32");
-        m_frame = QImage(*width, *height, QImage::Format_RGB32);
-        Q_ASSERT(!m_frame.isNull()); // ctor may construct null if allocation fails
-        m_frame.fill(0);
-        pitches[0] = m_frame.bytesPerLine();
-        lines[0] = m_frame.sizeInBytes() / m_frame.bytesPerLine();
-
-        return  m_frame.sizeInBytes();
-    }
-
-    void formatCleanUpCallback() override
+        QVariantMap statistics;
+        statistics.insert(QStringLiteral("delivered"), m_delivered.loadRelaxed());
+        statistics.insert(QStringLiteral("painted"), m_painted.loadRelaxed());
+        statistics.insert(QStringLiteral("dropped"), m_dropped.loadRelaxed());
+        statistics.insert(QStringLiteral("late"), m_late.loadRelaxed());
+        statistics.insert(QStringLiteral("paintTime"), m_paintTime / 1000);
+        statistics.insert(QStringLiteral("presentDelay"), m_presentDelay / 1000);
+        m_paintLatency.insertInto(&statistics, QStringLiteral("paintLatency"));
+        if (m_displayFrame) {
+            statistics.insert(QStringLiteral("presentationTime"), m_displayFrame->presentationTime);
+            statistics.insert(QStringLiteral("captureTime"), m_displayFrame->captureTime);
+        }
+        return statistics;
+    }
+
+    VideoWidget *widget;
+
+private:
+    void presentFrame(const SharedVideoFramePtr &frame) override
     {
-        // Lazy delete the object to avoid callbacks from VLC after deletion.
-        if (!widget) {
-            // The widget member is set to null by the widget destructor, so when this condition is true the
-            // widget had already been destroyed and we can't possibly receive a paint event anymore, meaning
-            // we need no lock here. If it were any other way we'd have trouble with synchronizing deletion
-            // without deleting a locked mutex.
-            delete this;
+        {
+            QMutexLocker lock(&m_frameMutex);
+            m_delivered.ref();
+            if (m_fresh) {
+                // Superseded before it got painted.
+                m_dropped.ref();
+            }
+            m_latestFrame = frame;
+            m_fresh = true;
         }
+
+        // One paint request in flight is enough, it paints whatever frame is
+        // the latest by then.
+        if (m_updatePending.testAndSetAcquire(0, 1))
+            QMetaObject::invokeMethod(widget, "presentSurfaceFrame", Qt::QueuedConnection);
+    }
+
+    QSize maximumFrameSize() const override
+    {
+        QMutexLocker lock(&m_frameMutex);
+        return m_maximumFrameSize;
     }
 
     QRect scaleToAspect(QRect srcRect, int w, int h) const
@@ -159,7 +229,8 @@ private:
             drawFrameRect = scaleToAspect(widgetRect, 16, 9);
             break;
         case Phonon::VideoWidget::AspectRatioAuto:
-            drawFrameRect = QRect(0, 0, m_frame.width(), m_frame.height());
+            // The frame may be scaled, the source has the exact aspect.
+            drawFrameRect = QRect(QPoint(0, 0), m_displayFrame->sourceSize);
             break;
         }
 
@@ -190,9 +261,30 @@ private:
         return drawFrameRect;
     }
 
-    // Could ReadWriteLock two frames so VLC can write while we paint.
-    QImage m_frame;
-    QMutex m_mutex;
+    /// Guards the frame handover with VLC's vout thread.
+    mutable QMutex m_frameMutex;
+    SharedVideoFramePtr m_latestFrame;
+    /// Whether m_latestFrame did not get painted yet.
+    bool m_fresh;
+    QSize m_maximumFrameSize;
+    /// Frame being displayed, GUI thread only.
+    SharedVideoFramePtr m_displayFrame;
+    /// Set while a paint is requested but did not happen yet.
+    QAtomicInt m_updatePending;
+    QAtomicInt m_delivered;
+    QAtomicInt m_painted;
+    QAtomicInt m_dropped;
+    QAtomicInt m_late;
+    /// Nanoseconds, GUI thread only.
+    qint64 m_refreshInterval;
+    /// Moving averages in nanoseconds, GUI thread only.
+    qint64 m_paintTime;
+    qint64 m_presentDelay;
+    /// From the end of decoding to the end of the paint, GUI thread only.
+    LatencyStatistics m_paintLatency;
+    YuvConverter m_converter;
+    /// Paint time conversion target, GUI thread only.
+    QImage m_scaledFrame;
 };
 
 VideoWidget::VideoWidget(QWidget *parent) :
@@ -202,11 +294,17 @@ VideoWidget::VideoWidget(QWidget *parent) :
     m_aspectRatio(Phonon::VideoWidget::AspectRatioAuto),
     m_scaleMode(Phonon::VideoWidget::FitInView),
     m_filterAdjustActivated(false),
+    m_surfaceAdjustActivated(false),
     m_brightness(0.0),
     m_contrast(0.0),
     m_hue(0.0),
     m_saturation(0.0),
-    m_surfacePainter(0)
+    m_surfacePainter(0),
+    m_presentTimer(0),
+    m_refreshInterval(qFloor(1000 / DEFAULT_REFRESH_RATE)),
+    m_overlay(0),
+    m_overlayTimer(0),
+    m_bufferLevel(100)
 {
     // We want background painting so Qt autofills with black.
     setAttribute(Qt::WA_NoSystemBackground, false);
@@ -222,12 +320,17 @@ VideoWidget::VideoWidget(QWidget *parent) :
     p.setColor(backgroundRole(), Qt::black);
     setPalette(p);
     setAutoFillBackground(true);
+
+    if (qEnvironmentVariableIntValue("PHONON_VLC_OVERLAY"))
+        setPerformanceOverlay(true);
 }
 
 VideoWidget::~VideoWidget()
 {
-    if (m_surfacePainter)
-        m_surfacePainter->widget = 0; // Lazy delete
+    if (m_frameFanout)
+        m_frameFanout->removeReceiver(m_surfacePainter);
+    delete m_surfacePainter;
+    delete m_overlay;
 }
 
 void VideoWidget::handleConnectToMediaObject(MediaObject *mediaObject)
@@ -238,8 +341,33 @@ void VideoWidget::handleConnectToMediaObject(MediaObject *mediaObject)
             SLOT(processPendingAdjusts(bool)));
     connect(mediaObject, SIGNAL(currentSourceChanged(MediaSource)),
             SLOT(clearPendingAdjusts()));
+    connect(mediaObject, SIGNAL(bufferStatus(int)),
+            SLOT(updateBufferLevel(int)));
 
+    m_bufferLevel = 100;
     clearPendingAdjusts();
+    updateVisibility();
+
+    // A native window shows the video in one widget only, whichever set it
+    // last. With a second widget on the media object all of them paint the
+    // frames of the shared fan-out instead.
+    QList<VideoWidget *> widgets;
+    foreach (SinkNode *sink, mediaObject->sinks()) {
+        if (VideoWidget *widget = dynamic_cast<VideoWidget *>(sink))
+            widgets.append(widget);
+    }
+    if (widgets.size() < 2)
+        return;
+    bool switched = false;
+    foreach (VideoWidget *widget, widgets) {
+        if (!widget->m_surfacePainter) {
+            widget->enableSurfacePainter();
+            switched = true;
+        }
+    }
+    // A running vout keeps its window, only a new one uses the fan-out.
+    if (switched)
+        mediaObject->restartVideo();
 }
 
 void VideoWidget::handleDisconnectFromMediaObject(MediaObject *mediaObject)
@@ -247,10 +375,22 @@ void VideoWidget::handleDisconnectFromMediaObject(MediaObject *mediaObject)
     // Undo all connections or path creation->destruction->creation can cause
     // duplicated connections or getting signals from two different MediaObjects.
     disconnect(mediaObject, 0, this, 0);
+
+    if (m_frameFanout) {
+        m_frameFanout->removeReceiver(m_surfacePainter);
+        m_frameFanout = 0;
+    }
 }
 
 void VideoWidget::handleAddToMedia(Media *media)
 {
+    // Without the video option libVLC creates no video output at all, which
+    // spares decoding cover art as video.
+    if (m_mediaObject && m_mediaObject->isAudioOnly()) {
+        debug() << "audio only media, not setting up video output";
+        return;
+    }
+
     media->addOption(":video");
 
     if (!m_surfacePainter) {
@@ -265,6 +405,8 @@ void VideoWidget::handleAddToMedia(Media *media)
 #elif defined(Q_OS_WIN)
         m_player->setHwnd((HWND)winId());
 #endif
+    } else {
+        attachSurfacePainter();
     }
 }
 
@@ -324,6 +466,12 @@ void VideoWidget::setBrightness(qreal brightness)
     if (!m_player) {
         return;
     }
+    if (m_surfacePainter) {
+        m_brightness = brightness;
+        m_surfaceAdjustActivated = true;
+        updateSurfaceAdjust();
+        return;
+    }
     if (!enableFilterAdjust()) {
         // Add to pending adjusts
         m_pendingAdjusts.insert(QByteArray("setBrightness"), brightness);
@@ -347,6 +495,12 @@ void VideoWidget::setContrast(qreal contrast)
     if (!m_player) {
         return;
     }
+    if (m_surfacePainter) {
+        m_contrast = contrast;
+        m_surfaceAdjustActivated = true;
+        updateSurfaceAdjust();
+        return;
+    }
     if (!enableFilterAdjust()) {
         // Add to pending adjusts
         m_pendingAdjusts.insert(QByteArray("setContrast"), contrast);
@@ -369,6 +523,12 @@ void VideoWidget::setHue(qreal hue)
     if (!m_player) {
         return;
     }
+    if (m_surfacePainter) {
+        m_hue = hue;
+        m_surfaceAdjustActivated = true;
+        updateSurfaceAdjust();
+        return;
+    }
     if (!enableFilterAdjust()) {
         // Add to pending adjusts
         m_pendingAdjusts.insert(QByteArray("setHue"), hue);
@@ -406,6 +566,12 @@ void VideoWidget::setSaturation(qreal saturation)
     if (!m_player) {
         return;
     }
+    if (m_surfacePainter) {
+        m_saturation = saturation;
+        m_surfaceAdjustActivated = true;
+        updateSurfaceAdjust();
+        return;
+    }
     if (!enableFilterAdjust()) {
         // Add to pending adjusts
         m_pendingAdjusts.insert(QByteArray("setSaturation"), saturation);
@@ -465,11 +631,164 @@ void VideoWidget::clearPendingAdjusts()
     m_pendingAdjusts.clear();
 }
 
+bool VideoWidget::event(QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::Show:
+        watchWindow();
+        updateVisibility();
+        updateSurfaceScreen();
+        break;
+    case QEvent::Hide:
+        updateVisibility();
+        break;
+    case QEvent::ScreenChangeInternal:
+        updateSurfaceScreen();
+        break;
+    default:
+        break;
+    }
+    return BaseWidget::event(event);
+}
+
+bool VideoWidget::eventFilter(QObject *watched, QEvent *event)
+{
+    // Minimizing leaves the widget visible as far as Qt is concerned.
+    if (watched == m_watchedWindow && event->type() == QEvent::WindowStateChange)
+        updateVisibility();
+    return BaseWidget::eventFilter(watched, event);
+}
+
+void VideoWidget::watchWindow()
+{
+    QWidget *window = this->window();
+    if (window == m_watchedWindow)
+        return;
+    if (m_watchedWindow)
+        m_watchedWindow->removeEventFilter(this);
+    m_watchedWindow = window;
+    m_watchedWindow->installEventFilter(this);
+}
+
+void VideoWidget::updateVisibility()
+{
+    if (!m_mediaObject)
+        return;
+    m_mediaObject->setVideoSinkVisible(this, isVisible() && !window()->isMinimized());
+}
+
+void VideoWidget::updateSurfaceScreen()
+{
+    QScreen *screen = this->screen();
+    if (!m_surfacePainter || !screen)
+        return;
+    m_surfacePainter->setMaximumFrameSize(screen->size() * screen->devicePixelRatio());
+    const qreal refreshRate = screen->refreshRate() > 0 ? screen->refreshRate() : DEFAULT_REFRESH_RATE;
+    m_surfacePainter->setRefreshRate(refreshRate);
+    m_refreshInterval = qMax(1, qFloor(1000 / refreshRate));
+}
+
+void VideoWidget::presentSurfaceFrame()
+{
+    // Paint at most once per display refresh. Frames displayed in between
+    // replace the waiting one in the painter rather than queueing paints.
+    if (m_lastSurfacePaint.isValid()) {
+        const qint64 remaining = m_refreshInterval - m_lastSurfacePaint.elapsed();
+        if (remaining > 0) {
+            if (!m_presentTimer->isActive())
+                m_presentTimer->start(remaining);
+            return;
+        }
+    }
+    update();
+}
+
+QVariantMap VideoWidget::frameStatistics() const
+{
+    if (!m_surfacePainter)
+        return QVariantMap();
+    return m_surfacePainter->statistics();
+}
+
+void VideoWidget::updateSurfaceAdjust()
+{
+    // Fused into the frame conversion, so neither VLC's adjust filter nor a
+    // vout is needed.
+    // Like VLC's filter the adjustments only apply once one was set, their
+    // neutral saturation is not the identity.
+    if (!m_surfacePainter || !(m_surfaceAdjustActivated || m_filterAdjustActivated))
+        return;
+    if (m_filterAdjustActivated) {
+        // Taken over from VLC's filter, which must not apply them again.
+        if (m_player)
+            m_player->setVideoAdjust(libvlc_adjust_Enable, 0);
+        m_filterAdjustActivated = false;
+        m_surfaceAdjustActivated = true;
+    }
+    m_surfacePainter->setAdjust(m_brightness, m_contrast, m_hue, m_saturation);
+    // Repaint right away, the video may be paused.
+    update();
+}
+
 void VideoWidget::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event);
-    if (m_surfacePainter)
+    if (m_surfacePainter) {
+        m_lastSurfacePaint.start();
         m_surfacePainter->handlePaint(event);
+        if (m_overlay) {
+            QPainter painter(this);
+            m_overlay->paint(&painter, rect());
+        }
+    }
+}
+
+void VideoWidget::setPerformanceOverlay(bool enable)
+{
+    if (enable == hasPerformanceOverlay())
+        return;
+
+    if (!enable) {
+        delete m_overlay;
+        m_overlay = 0;
+        m_overlayTimer->stop();
+        if (m_surfacePainter)
+            update();
+        else if (m_player)
+            m_player->setMarqueeText(QString());
+        return;
+    }
+
+    m_overlay = new PerformanceOverlay;
+    if (!m_overlayTimer) {
+        m_overlayTimer = new QTimer(this);
+        m_overlayTimer->setInterval(1000);
+        connect(m_overlayTimer, SIGNAL(timeout()), this, SLOT(updatePerformanceOverlay()));
+    }
+    m_overlayTimer->start();
+    updatePerformanceOverlay();
+}
+
+bool VideoWidget::hasPerformanceOverlay() const
+{
+    return m_overlay;
+}
+
+void VideoWidget::updatePerformanceOverlay()
+{
+    if (!m_overlay)
+        return;
+
+    m_overlay->sample(m_player, frameStatistics(), m_bufferLevel);
+    if (m_surfacePainter)
+        update(); // Drawn in paintEvent, also when paused.
+    else if (m_player)
+        m_player->setMarqueeText(m_overlay->text());
+}
+
+void VideoWidget::updateBufferLevel(int percentFilled)
+{
+    m_bufferLevel = percentFilled;
 }
 
 bool VideoWidget::enableFilterAdjust(bool adjust)
@@ -523,12 +842,27 @@ float VideoWidget::phononRangeToVlcRange(qreal phononValue, float upperBoundary,
 QImage VideoWidget::snapshot() const
 {
     DEBUG_BLOCK;
-    if (m_player)
+    if (m_surfacePainter)
+        return m_surfacePainter->snapshot();
+    else if (m_player)
         return m_player->snapshot();
     else
         return QImage();
 }
 
+void VideoWidget::requestSnapshot()
+{
+    if (m_surfacePainter || !m_player) {
+        // Cheap enough to do right away, deliver it like the slow path does.
+        QMetaObject::invokeMethod(this, "snapshotTaken", Qt::QueuedConnection,
+                                  Q_ARG(QImage, snapshot()));
+        return;
+    }
+    connect(m_player, SIGNAL(snapshotTaken(QImage)),
+            this, SIGNAL(snapshotTaken(QImage)), Qt::UniqueConnection);
+    m_player->requestSnapshot();
+}
+
 void VideoWidget::enableSurfacePainter()
 {
     if (m_surfacePainter) {
@@ -538,7 +872,20 @@ void VideoWidget::enableSurfacePainter()
     debug() << "ENABLING SURFACE PAINTING";
     m_surfacePainter = new SurfacePainter;
     m_surfacePainter->widget = this;
-    m_surfacePainter->setCallbacks(m_player);
+    m_presentTimer = new QTimer(this);
+    m_presentTimer->setSingleShot(true);
+    m_presentTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_presentTimer, SIGNAL(timeout()), this, SLOT(update()));
+    updateSurfaceScreen();
+    updateSurfaceAdjust();
+    attachSurfacePainter();
+}
+
+void VideoWidget::attachSurfacePainter()
+{
+    // Every widget showing the player's video shares its frames, the player
+    // only has the one set of callbacks.
+    m_frameFanout = VideoFrameFanout::attach(m_surfacePainter, m_player, m_frameFanout);
 }
 
 } // namespace VLC
@@ -22,6 +22,9 @@
 #ifndef PHONON_VLC_VIDEOWIDGET_H
 #define PHONON_VLC_VIDEOWIDGET_H
 
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QVariantMap>
 #include <QWidget>
 
 #include <phonon/videowidgetinterface.h>
@@ -35,10 +38,14 @@ typedef QWidget BaseWidget;
 
 #include "sinknode.h"
 
+class QTimer;
+
 namespace Phonon {
 namespace VLC {
 
+class PerformanceOverlay;
 class SurfacePainter;
+class VideoFrameFanout;
 
 /** \brief Implements the Phonon VideoWidget MediaNode, responsible for displaying video
  *
@@ -80,6 +87,8 @@ public:
     void handleDisconnectFromMediaObject(MediaObject *mediaObject) override;
     /** \reimp */
     void handleAddToMedia(Media *media) override;
+    /** \reimp */
+    bool isVideoSink() const override { return true; }
 
     /**
      * \return The aspect ratio previously set for the video widget
@@ -156,6 +165,48 @@ public:
 
     void setVisible(bool visible) override;
 
+    /**
+     * Frame counters of the surface painter, empty when it is not in use:
+     * \li delivered - frames VLC handed over for display
+     * \li painted - frames that got painted
+     * \li dropped - frames superseded by a newer one before they got painted
+     * \li late - painted frames that took longer than a display refresh from
+     *     their display time to the paint
+     * \li paintTime - average time a paint takes, in microseconds
+     * \li presentDelay - average time from a frame's display time to its
+     *     paint, in microseconds
+     * \li paintLatency50, paintLatency90, paintLatency99 - percentiles of the
+     *     time from the end of decoding to the end of the paint over recent
+     *     frames, in microseconds
+     * \li presentationTime - media time of the frame on screen, in msecs
+     * \li captureTime - when that frame got decoded, on the monotonic clock
+     *     QElapsedTimer uses, in nanoseconds
+     */
+    Q_INVOKABLE QVariantMap frameStatistics() const;
+
+    /**
+     * Shows playback performance figures on top of the video: bitrate,
+     * decoded, displayed and dropped frames, buffer level and paint timing.
+     * Updated once a second. Drawn by the surface painter when it is in use,
+     * through libVLC's marquee otherwise.
+     *
+     * Also enabled by setting the environment variable PHONON_VLC_OVERLAY=1.
+     * Only then does libVLC collect statistics, so when enabled through this
+     * call alone the overlay shows buffer level and paint timing only.
+     */
+    Q_INVOKABLE void setPerformanceOverlay(bool enable);
+    Q_INVOKABLE bool hasPerformanceOverlay() const;
+
+    /**
+     * Asynchronous snapshot() for the native video output, where libVLC has
+     * to encode a file. Delivered through snapshotTaken(), always queued.
+     */
+    Q_INVOKABLE void requestSnapshot();
+
+Q_SIGNALS:
+    /// Result of requestSnapshot(), a null image if none could be taken.
+    void snapshotTaken(const QImage &image);
+
 private Q_SLOTS:
     /// Updates the sizeHint to match the native size of the video.
     /// \param hasVideo \c true when there is a video, \c false otherwise
@@ -174,7 +225,20 @@ private Q_SLOTS:
      */
     void clearPendingAdjusts();
 
+    /// Requests a paint for a new surface frame, paced to the display refresh.
+    void presentSurfaceFrame();
+
+    /// Takes a new sample of the performance figures and shows them.
+    void updatePerformanceOverlay();
+
+    /// Keeps track of the input buffer level for the performance overlay.
+    void updateBufferLevel(int percentFilled);
+
 protected:
+    /// \reimp
+    bool event(QEvent *event) override;
+    /// \reimp
+    bool eventFilter(QObject *watched, QEvent *event) override;
     /// \reimp
     void paintEvent(QPaintEvent *event) override;
 
@@ -215,7 +279,9 @@ private:
                                        bool shift = true);
 
     /**
-     * \return The snapshot of the current video frame.
+     * \return The snapshot of the current video frame. With the surface
+     * painter this is a plain conversion of the latest frame, otherwise
+     * libVLC takes it through a temporary file.
      */
     QImage snapshot() const override;
 
@@ -224,6 +290,27 @@ private:
      */
     void enableSurfacePainter();
 
+    /// Makes the surface painter receive the frames of the current player.
+    void attachSurfacePainter();
+
+    /**
+     * Adapts the surface painter to the widget's screen: frames are limited
+     * to its physical size and paints to its refresh rate.
+     */
+    void updateSurfaceScreen();
+
+    /// Hands the current picture adjustments to the surface painter.
+    void updateSurfaceAdjust();
+
+    /// Watches the top level window for minimization.
+    void watchWindow();
+
+    /**
+     * Reports to the MediaObject whether the video can be seen, so decoding
+     * can be suspended while it can't.
+     */
+    void updateVisibility();
+
     /**
      * Pending video adjusts the application tried to set before we actually
      * had a video to set them on.
@@ -239,12 +326,24 @@ private:
     Phonon::VideoWidget::ScaleMode m_scaleMode;
 
     bool  m_filterAdjustActivated;
+    /// Whether adjustments were set while the surface painter is in use.
+    bool  m_surfaceAdjustActivated;
     qreal m_brightness;
     qreal m_contrast;
     qreal m_hue;
     qreal m_saturation;
 
     SurfacePainter *m_surfacePainter;
+    QPointer<VideoFrameFanout> m_frameFanout;
+    QTimer *m_presentTimer;
+    QPointer<QWidget> m_watchedWindow;
+    QElapsedTimer m_lastSurfacePaint;
+    /// Display refresh interval in msecs.
+    int m_refreshInterval;
+
+    PerformanceOverlay *m_overlay;
+    QTimer *m_overlayTimer;
+    int m_bufferLevel;
 };
 
 } // namespace VLC
@@ -0,0 +1,345 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "yuvconverter.h"
+
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVarLengthArray>
+#include <QtCore/qmath.h>
+#include <QtGui/QImage>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PHONON_VLC_YUV_SSE2
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+#define PHONON_VLC_YUV_NEON
+#include <arm_neon.h>
+#endif
+
+// Stripes smaller than this are not worth a thread hop.
+#define MIN_STRIPE_ROWS 64
+// Painting is latency bound, more threads mostly add wakeup overhead.
+#define MAX_STRIPE_THREADS 3
+
+namespace Phonon {
+namespace VLC {
+
+class StripePool : public QThreadPool
+{
+public:
+    StripePool()
+    {
+        setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, MAX_STRIPE_THREADS));
+    }
+};
+
+Q_GLOBAL_STATIC(StripePool, stripePool)
+
+/**
+ * Maps target position \p i onto the source in 1/256 pixel units with pixel
+ * centres aligned, yielding the two neighbouring source pixels and the weight
+ * of the second one.
+ */
+static inline void mapPosition(int i, int sourceSize, int targetSize,
+                               int *first, int *second, int *weight)
+{
+    const int position = qMax(0, int(qint64(2 * i + 1) * sourceSize * 128 / targetSize) - 128);
+    *first = position >> 8;
+    *weight = position & 0xff;
+    if (*first >= sourceSize - 1) {
+        *first = sourceSize - 1;
+        *weight = 0;
+    }
+    *second = qMin(*first + 1, sourceSize - 1);
+}
+
+template <typename Tap>
+static inline void resampleRow(const uchar *row0, const uchar *row1, int rowWeight,
+                               const Tap *taps, int count, uchar *out)
+{
+    const int weight0 = 256 - rowWeight;
+    for (int x = 0; x < count; ++x) {
+        const Tap &tap = taps[x];
+        const int top = row0[tap.first] * (256 - tap.weight) + row0[tap.second] * tap.weight;
+        const int bottom = row1[tap.first] * (256 - tap.weight) + row1[tap.second] * tap.weight;
+        out[x] = uchar((top * weight0 + bottom * rowWeight + (1 << 15)) >> 16);
+    }
+}
+
+// Limited range luma scale, same for both colour spaces.
+#define Y_SCALE 1.164383f
+
+// Frames taller than SD are taken to be HD, like VideoSinkOutput does.
+#define SD_MAX_HEIGHT 576
+
+/// Chroma factors for limited range input, per colour space.
+static const struct {
+    float vToR;
+    float uToG;
+    float vToG;
+    float uToB;
+} s_chromaFactors[] = {
+    { 1.596027f, 0.391762f, 0.812968f, 2.017232f }, // BT.601
+    { 1.792741f, 0.213249f, 0.532909f, 2.112402f }  // BT.709
+};
+
+typedef YuvConverter::ColorMatrix ColorMatrix;
+
+/// \p y is already scaled by the luma factor, \p u and \p v are centred.
+static inline int toChannel(const ColorMatrix &matrix, int channel, float y, float u, float v)
+{
+    const float value = y + u * matrix.u[channel] + v * matrix.v[channel] + matrix.offset[channel];
+    return qBound(0, int(value + 0.5f), 255);
+}
+
+#if defined(PHONON_VLC_YUV_SSE2)
+/// Sign extends half of eight 16 bit lanes to floats.
+static inline __m128 toFloat(__m128i value, bool high)
+{
+    const __m128i widened = high ? _mm_unpackhi_epi16(value, value) : _mm_unpacklo_epi16(value, value);
+    return _mm_cvtepi32_ps(_mm_srai_epi32(widened, 16));
+}
+
+static inline __m128i toChannel(const ColorMatrix &matrix, int channel, __m128 y, __m128 u, __m128 v)
+{
+    const __m128 chroma = _mm_add_ps(_mm_mul_ps(u, _mm_set1_ps(matrix.u[channel])),
+                                     _mm_mul_ps(v, _mm_set1_ps(matrix.v[channel])));
+    return _mm_cvtps_epi32(_mm_add_ps(_mm_add_ps(y, chroma), _mm_set1_ps(matrix.offset[channel])));
+}
+
+static inline void convertHalf(const ColorMatrix &matrix, __m128i y, __m128i u, __m128i v, bool high,
+                               __m128i *r, __m128i *g, __m128i *b)
+{
+    const __m128 yf = _mm_mul_ps(toFloat(y, high), _mm_set1_ps(matrix.luma));
+    const __m128 uf = toFloat(u, high);
+    const __m128 vf = toFloat(v, high);
+    *r = toChannel(matrix, 0, yf, uf, vf);
+    *g = toChannel(matrix, 1, yf, uf, vf);
+    *b = toChannel(matrix, 2, yf, uf, vf);
+}
+#elif defined(PHONON_VLC_YUV_NEON)
+static inline int32x4_t toChannel(const ColorMatrix &matrix, int channel,
+                                  float32x4_t y, float32x4_t u, float32x4_t v)
+{
+    // Biased by a half so truncation rounds, negative values clamp anyway.
+    const float32x4_t base = vaddq_f32(y, vdupq_n_f32(matrix.offset[channel] + 0.5f));
+    return vcvtq_s32_f32(vmlaq_n_f32(vmlaq_n_f32(base, u, matrix.u[channel]), v, matrix.v[channel]));
+}
+
+static inline void convertHalf(const ColorMatrix &matrix, int16x4_t y, int16x4_t u, int16x4_t v,
+                               int32x4_t *r, int32x4_t *g, int32x4_t *b)
+{
+    const float32x4_t yf = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(y)), matrix.luma);
+    const float32x4_t uf = vcvtq_f32_s32(vmovl_s16(u));
+    const float32x4_t vf = vcvtq_f32_s32(vmovl_s16(v));
+    *r = toChannel(matrix, 0, yf, uf, vf);
+    *g = toChannel(matrix, 1, yf, uf, vf);
+    *b = toChannel(matrix, 2, yf, uf, vf);
+}
+#endif
+
+static void convertRow(const ColorMatrix &matrix,
+                       const uchar *y, const uchar *u, const uchar *v, QRgb *out, int count)
+{
+    int x = 0;
+#if defined(PHONON_VLC_YUV_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i chromaBias = _mm_set1_epi16(128);
+    const __m128i alpha = _mm_set1_epi8(char(0xff));
+    for (; x + 8 <= count; x += 8) {
+        const __m128i y16 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(y + x)), zero);
+        const __m128i u16 = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(u + x)), zero), chromaBias);
+        const __m128i v16 = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(v + x)), zero), chromaBias);
+
+        __m128i rLow, gLow, bLow, rHigh, gHigh, bHigh;
+        convertHalf(matrix, y16, u16, v16, false, &rLow, &gLow, &bLow);
+        convertHalf(matrix, y16, u16, v16, true, &rHigh, &gHigh, &bHigh);
+        const __m128i r = _mm_packus_epi16(_mm_packs_epi32(rLow, rHigh), zero);
+        const __m128i g = _mm_packus_epi16(_mm_packs_epi32(gLow, gHigh), zero);
+        const __m128i b = _mm_packus_epi16(_mm_packs_epi32(bLow, bHigh), zero);
+
+        // Little endian 0xAARRGGBB is B, G, R, A in memory.
+        const __m128i bg = _mm_unpacklo_epi8(b, g);
+        const __m128i ra = _mm_unpacklo_epi8(r, alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x + 4), _mm_unpackhi_epi16(bg, ra));
+    }
+#elif defined(PHONON_VLC_YUV_NEON)
+    for (; x + 8 <= count; x += 8) {
+        const int16x8_t y16 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y + x)));
+        const int16x8_t u16 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u + x))), vdupq_n_s16(128));
+        const int16x8_t v16 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v + x))), vdupq_n_s16(128));
+
+        int32x4_t rLow, gLow, bLow, rHigh, gHigh, bHigh;
+        convertHalf(matrix, vget_low_s16(y16), vget_low_s16(u16), vget_low_s16(v16), &rLow, &gLow, &bLow);
+        convertHalf(matrix, vget_high_s16(y16), vget_high_s16(u16), vget_high_s16(v16), &rHigh, &gHigh, &bHigh);
+
+        uint8x8x4_t pixels;
+        pixels.val[0] = vqmovun_s16(vcombine_s16(vqmovn_s32(bLow), vqmovn_s32(bHigh)));
+        pixels.val[1] = vqmovun_s16(vcombine_s16(vqmovn_s32(gLow), vqmovn_s32(gHigh)));
+        pixels.val[2] = vqmovun_s16(vcombine_s16(vqmovn_s32(rLow), vqmovn_s32(rHigh)));
+        pixels.val[3] = vdup_n_u8(0xff);
+        vst4_u8(reinterpret_cast<uint8_t *>(out + x), pixels);
+    }
+#endif
+    for (; x < count; ++x) {
+        const float luma = y[x] * matrix.luma;
+        const float chromaU = u[x] - 128;
+        const float chromaV = v[x] - 128;
+        out[x] = qRgb(toChannel(matrix, 0, luma, chromaU, chromaV),
+                      toChannel(matrix, 1, luma, chromaU, chromaV),
+                      toChannel(matrix, 2, luma, chromaU, chromaV));
+    }
+}
+
+YuvConverter::YuvConverter()
+    : m_tapsTargetWidth(0)
+    , m_tapsLayout(Planar)
+{
+    // No adjustment at all, setAdjust(0, 0, 0, 0) raises the saturation.
+    updateMatrices(0.0f, 1.0f, 1.0f, 0.0f);
+}
+
+void YuvConverter::setAdjust(qreal brightness, qreal contrast, qreal hue, qreal saturation)
+{
+    // Same operations as VLC's adjust filter, applied in YUV before the
+    // conversion: luma is scaled around mid grey and offset, chroma is
+    // rotated and scaled. All of it is linear, so it folds into the matrix.
+    // The ranges are those VideoWidget maps to for the filter: saturation
+    // goes up to 3.0, so 0.0 already gives 1.5.
+    const float lumaOffset = float(qBound<qreal>(-1.0, brightness, 1.0)) * 255.0f;
+    const float lumaGain = float(qBound<qreal>(-1.0, contrast, 1.0)) + 1.0f;
+    const float chromaGain = 1.5f * (float(qBound<qreal>(-1.0, saturation, 1.0)) + 1.0f);
+    const float angle = float(qBound<qreal>(-1.0, hue, 1.0) * M_PI);
+    updateMatrices(lumaOffset, lumaGain, chromaGain, angle);
+}
+
+void YuvConverter::updateMatrices(float lumaOffset, float lumaGain, float chromaGain, float angle)
+{
+    const float cosine = chromaGain * qCos(angle);
+    const float sine = chromaGain * qSin(angle);
+    const float offset = Y_SCALE * (128.0f - 128.0f * lumaGain + lumaOffset - 16.0f);
+
+    // u' = cos * u + sin * v, v' = cos * v - sin * u
+    for (int space = BT601; space <= BT709; ++space) {
+        ColorMatrix &matrix = m_matrices[space];
+        const auto &factors = s_chromaFactors[space];
+        matrix.luma = Y_SCALE * lumaGain;
+        for (int channel = 0; channel < 3; ++channel) {
+            matrix.offset[channel] = offset;
+        }
+        matrix.u[0] = -factors.vToR * sine;
+        matrix.v[0] = factors.vToR * cosine;
+        matrix.u[1] = -factors.uToG * cosine + factors.vToG * sine;
+        matrix.v[1] = -factors.uToG * sine - factors.vToG * cosine;
+        matrix.u[2] = factors.uToB * cosine;
+        matrix.v[2] = factors.uToB * sine;
+    }
+}
+
+YuvConverter::ColorSpace YuvConverter::colorSpace(const QSize &size)
+{
+    // VLC does not hand out the colour space of the pictures, go with what
+    // SD and HD video commonly use.
+    return size.height() > SD_MAX_HEIGHT ? BT709 : BT601;
+}
+
+void YuvConverter::buildTaps(QVector<Tap> *taps, int sourceWidth, int targetWidth, int step)
+{
+    taps->resize(targetWidth);
+    for (int x = 0; x < targetWidth; ++x) {
+        Tap &tap = (*taps)[x];
+        mapPosition(x, sourceWidth, targetWidth, &tap.first, &tap.second, &tap.weight);
+        tap.first *= step;
+        tap.second *= step;
+    }
+}
+
+void YuvConverter::convert(const Frame &frame, QImage *target)
+{
+    Q_ASSERT(target->format() == QImage::Format_RGB32);
+    if (target->isNull() || frame.size.isEmpty())
+        return;
+
+    const QSize targetSize = target->size();
+    if (m_tapsSourceSize != frame.size || m_tapsTargetWidth != targetSize.width()
+            || m_tapsLayout != frame.layout) {
+        const int chromaStep = frame.layout == SemiPlanar ? 2 : 1;
+        buildTaps(&m_lumaTaps, frame.size.width(), targetSize.width(), 1);
+        buildTaps(&m_chromaTaps, (frame.size.width() + 1) / 2, targetSize.width(), chromaStep);
+        m_tapsSourceSize = frame.size;
+        m_tapsTargetWidth = targetSize.width();
+        m_tapsLayout = frame.layout;
+    }
+
+    // Detach here, bits() must not be called from the stripe threads.
+    uchar *bits = target->bits();
+    const int bytesPerLine = target->bytesPerLine();
+
+    StripePool *pool = stripePool();
+    const int stripes = qBound(1, targetSize.height() / MIN_STRIPE_ROWS, pool->maxThreadCount() + 1);
+    QSemaphore done;
+    for (int i = 1; i < stripes; ++i) {
+        const int firstRow = targetSize.height() * i / stripes;
+        const int lastRow = targetSize.height() * (i + 1) / stripes;
+        pool->start([=, &frame, &done]() {
+            convertRows(frame, bits, bytesPerLine, targetSize, firstRow, lastRow);
+            done.release();
+        });
+    }
+    // The calling thread does its share rather than idling.
+    convertRows(frame, bits, bytesPerLine, targetSize, 0, targetSize.height() / stripes);
+    done.acquire(stripes - 1);
+}
+
+void YuvConverter::convertRows(const Frame &frame, uchar *bits, int bytesPerLine,
+                               const QSize &targetSize, int firstRow, int lastRow) const
+{
+    const int width = targetSize.width();
+    const int chromaHeight = (frame.size.height() + 1) / 2;
+    const uchar *lumaPlane = frame.planes[0];
+    const uchar *uPlane = frame.planes[1];
+    const uchar *vPlane = frame.layout == SemiPlanar ? frame.planes[1] + 1 : frame.planes[2];
+    const int vPitch = frame.layout == SemiPlanar ? frame.pitches[1] : frame.pitches[2];
+
+    const ColorMatrix &matrix = m_matrices[colorSpace(frame.size)];
+
+    QVarLengthArray<uchar, 4096> y(width);
+    QVarLengthArray<uchar, 4096> u(width);
+    QVarLengthArray<uchar, 4096> v(width);
+
+    for (int row = firstRow; row < lastRow; ++row) {
+        int first, second, weight;
+        mapPosition(row, frame.size.height(), targetSize.height(), &first, &second, &weight);
+        resampleRow(lumaPlane + first * frame.pitches[0], lumaPlane + second * frame.pitches[0],
+                    weight, m_lumaTaps.constData(), width, y.data());
+
+        mapPosition(row, chromaHeight, targetSize.height(), &first, &second, &weight);
+        resampleRow(uPlane + first * frame.pitches[1], uPlane + second * frame.pitches[1],
+                    weight, m_chromaTaps.constData(), width, u.data());
+        resampleRow(vPlane + first * vPitch, vPlane + second * vPitch,
+                    weight, m_chromaTaps.constData(), width, v.data());
+
+        convertRow(matrix, y.constData(), u.constData(), v.constData(),
+                   reinterpret_cast<QRgb *>(bits + row * bytesPerLine), width);
+    }
+}
+
+} // namespace VLC
+} // namespace Phonon
@@ -0,0 +1,128 @@
+/*
+    Copyright (C) 2026 vlc-phonon AUTHORS <kde-multimedia@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_VLC_YUVCONVERTER_H
+#define PHONON_VLC_YUVCONVERTER_H
+
+#include <QtCore/QSize>
+#include <QtCore/QVector>
+
+class QImage;
+
+namespace Phonon {
+namespace VLC {
+
+/** \brief Fused scaling and conversion of 4:2:0 YUV frames to RGB32
+ *
+ * Converting the full frame to RGB in VLC and then scaling it with QPainter
+ * touches every source pixel twice and every intermediate pixel once more.
+ * The converter instead resamples each target row straight from the YUV
+ * planes (bilinear, in fixed point) and converts it to RGB in the same pass,
+ * so only the target resolution worth of pixels is ever produced.
+ *
+ * Picture adjustments (brightness etc.) are folded into the conversion
+ * matrix, so they come at no extra cost. Input is taken to be limited range,
+ * BT.709 for HD frames and BT.601 otherwise (see colorSpace()).
+ *
+ * The colour conversion is vectorised with SSE2 or NEON where the compiler
+ * targets them and falls back to plain C++ otherwise. Target rows are split
+ * into stripes that are converted in parallel on a small shared thread pool.
+ */
+class YuvConverter
+{
+public:
+    enum ColorSpace {
+        BT601,
+        BT709
+    };
+
+    enum Layout {
+        /// Separate U and V planes (I420, YV12 with U/V swapped by the caller).
+        Planar,
+        /// Interleaved UV plane (NV12).
+        SemiPlanar
+    };
+
+    struct Frame
+    {
+        /// Luma size, chroma is subsampled by two in both directions.
+        QSize size;
+        Layout layout;
+        /// Y, U, V; for SemiPlanar Y and UV.
+        const uchar *planes[3];
+        int pitches[3];
+    };
+
+    /// Per RGB channel factors on Y and U/V centred around zero.
+    struct ColorMatrix
+    {
+        float luma;
+        float u[3];
+        float v[3];
+        float offset[3];
+    };
+
+    YuvConverter();
+
+    /**
+     * Sets the picture adjustments applied as part of the conversion. All
+     * values are in Phonon's -1.0 to 1.0 range and mapped like VideoWidget
+     * does for VLC's adjust filter, so both look the same. As with the filter
+     * 0.0 leaves the picture unchanged except for saturation, which is 1.5
+     * times the original there. Hue rotates by up to 180 degrees in either
+     * direction. Without a call the picture is converted unchanged.
+     */
+    void setAdjust(qreal brightness, qreal contrast, qreal hue, qreal saturation);
+
+    /**
+     * Scales and converts \p frame into all of \p target, which must be an
+     * RGB32 image. Blocks until the conversion is complete.
+     */
+    void convert(const Frame &frame, QImage *target);
+
+    /// \returns the colour space frames of \p size are converted from
+    static ColorSpace colorSpace(const QSize &size);
+
+private:
+    /// Horizontal filter tap, offsets in bytes into a source row.
+    struct Tap
+    {
+        int first;
+        int second;
+        int weight;
+    };
+
+    /// Builds m_matrices from adjustments in VLC's adjust filter ranges.
+    void updateMatrices(float lumaOffset, float lumaGain, float chromaGain, float angle);
+
+    static void buildTaps(QVector<Tap> *taps, int sourceWidth, int targetWidth, int step);
+    void convertRows(const Frame &frame, uchar *bits, int bytesPerLine,
+                     const QSize &targetSize, int firstRow, int lastRow) const;
+
+    /// Indexed by ColorSpace.
+    ColorMatrix m_matrices[2];
+    QVector<Tap> m_lumaTaps;
+    QVector<Tap> m_chromaTaps;
+    QSize m_tapsSourceSize;
+    int m_tapsTargetWidth;
+    Layout m_tapsLayout;
+};
+
+} // namespace VLC
+} // namespace Phonon
+
+#endif // PHONON_VLC_YUVCONVERTER_H